@@ -10,6 +10,9 @@
 #include "assets.h"
 #include "transition.h"
 #include "audio.h"
+#include "timer.h"
+
+#include <i86.h>
 
 #include <stdlib.h>
 #include <stdio.h>
@@ -18,6 +21,19 @@
 // Maximum amount of scenes
 #define MAX_SCENES 16
 
+// Logic steps per second
+#define STEP_RATE 70
+// Maximum steps per update
+#define MAX_STEPS 8
+// Maximum frame skip
+#define MAX_FRAME_SKIP 3
+// Updates needed before changing the frame skip
+#define LATE_LIMIT 4
+#define ON_TIME_LIMIT 70
+
+// Timer ticks per step
+static const uint32 STEP_TICKS = TIMER_FREQ / STEP_RATE;
+
 // Scenes
 static Scene scenes[MAX_SCENES];
 // Scene count
@@ -30,6 +46,16 @@ static int16 frameSkip;
 // Step count
 static int16 stepCount;
 
+// Time of the previous update
+static uint32 oldTicks;
+// Time not yet simulated
+static uint32 accumulator;
+// Late & on time update counts
+static int16 lateCount;
+static int16 onTimeCount;
+// Dropped frames
+static uint16 droppedFrames;
+
 // Is running
 static boolean running;
 
@@ -48,10 +74,14 @@ static void dispose() {
     // Destroy components
     destroy_graphics();
     destroy_input();
+    destroy_timer();
 }
 
 // Update
 static void app_update(int16 steps) {
+
+    // Read input events
+    input_update();
     
      // Update active scene
     if(activeScene->update != NULL) {
@@ -66,6 +96,71 @@ static void app_update(int16 steps) {
 }
 
 
+// Get the amount of fixed steps since the last 
+// update & adjust frame skipping
+static int16 app_get_steps() {
+
+    uint32 ticks = timer_get_ticks();
+    uint32 late;
+    uint32 lostSteps = 0;
+    int16 steps;
+    int16 expected = frameSkip +1;
+
+    accumulator += ticks - oldTicks;
+    oldTicks = ticks;
+
+    // Too far behind, drop the extra time (the frames 
+    // in it are dropped, too)
+    if(accumulator > STEP_TICKS * MAX_STEPS) {
+
+        lostSteps = (accumulator - STEP_TICKS * MAX_STEPS) / STEP_TICKS;
+        accumulator = STEP_TICKS * MAX_STEPS;
+    }
+
+    steps = (int16)(accumulator / STEP_TICKS);
+    accumulator -= STEP_TICKS * steps;
+
+    // Running late: frames were dropped, skip more
+    // frames if this goes on
+    if(steps > expected) {
+
+        // Frames that should have been shown during
+        // the extra steps, rounded up
+        late = (uint32)(steps - expected) + lostSteps;
+        droppedFrames += (uint16)((late + expected-1) / expected);
+        onTimeCount = 0;
+        if(++ lateCount >= LATE_LIMIT && frameSkip < MAX_FRAME_SKIP) {
+
+            ++ frameSkip;
+            lateCount = 0;
+        }
+    }
+    // On time: try skipping less
+    else {
+
+        lateCount = 0;
+        if(++ onTimeCount >= ON_TIME_LIMIT && frameSkip > 0) {
+
+            -- frameSkip;
+            onTimeCount = 0;
+        }
+    }
+
+    return steps;
+}
+
+
+// Give the rest of the time slice away
+// (to DOSBox, Windows or other multitaskers)
+static void app_idle() {
+
+    union REGS r;
+
+    r.w.ax = 0x1680;
+    int86(0x2F, &r, &r);
+}
+
+
 // Draw
 static void app_draw() {
 
@@ -93,9 +188,11 @@ int16 init_application() {
     init_assets();
     init_transition();
     init_audio();
+    init_timer();
 
     // Set defaults params
     frameSkip = 1;
+    droppedFrames = 0;
 
     return 0;
 }
@@ -105,6 +202,7 @@ void app_run() {
 
     boolean updateFrame =false;
     int16 i = 0;
+    int16 steps;
 
     // Initialize scenes
     running = true;
@@ -119,6 +217,10 @@ void app_run() {
 
     // Start the main loop
     stepCount = 0;
+    accumulator = 0;
+    lateCount = 0;
+    onTimeCount = 0;
+    oldTicks = timer_get_ticks();
     while(running) {
 
         // Check frame skipping
@@ -132,18 +234,24 @@ void app_run() {
 
         // Update & render the active scene
         if(updateFrame 
-            && activeScene != NULL) {
+            && activeScene != NULL
+            && (steps = app_get_steps()) > 0) {
 
             // Update
-            app_update(frameSkip +1);
+            app_update(steps);
             // Draw
             app_draw();
         }
 
+        // Nothing new to show, no need to
+        // keep the CPU busy
+        if(!frame_changed())
+            app_idle();
+
         // Wait for the vertical sync
         vblank();
 
-        // Draw frame
+        // Draw frame (skipped if nothing was drawn)
         draw_frame();
     }
 
@@ -179,6 +287,9 @@ void app_change_scene(const char* name, void* param) {
         if(strcmp(scenes[i].name, name) == 0) {
 
             activeScene = &scenes[i];
+            // Saved overlay areas belong to
+            // the old scene
+            clear_save_under();
             if(activeScene->change != NULL) {
 
                 activeScene->change(param);
@@ -194,5 +305,12 @@ void app_change_scene(const char* name, void* param) {
 void app_terminate() {
 
     running = false;
+}
+
+
+// Get the number of dropped frames
+uint16 app_get_dropped_frames() {
+
+    return droppedFrames;
 }   
 
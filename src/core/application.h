@@ -22,4 +22,7 @@ void app_run();
 // Terminate
 void app_terminate();
 
+// Get the number of dropped frames
+uint16 app_get_dropped_frames();
+
 #endif // __APP_CORE__
@@ -109,6 +109,28 @@ bool ass_add_bitmap(const char* path, const char* name) {
 }
 
 
+// Add a bitmap with a mirrored copy
+bool ass_add_bitmap_mirrored(const char* path, const char* name) {
+
+    Bitmap* bmp;
+
+    // Load bitmap
+    bmp = load_bitmap(path);
+    if(bmp == NULL)
+        return false;
+
+    // Mirror & put to the asset storage
+    if(!bitmap_create_mirror(bmp) ||
+       !put_asset((void*)bmp, name, TypeBitmap)) {
+
+        destroy_bitmap(bmp);
+        return false;
+    }
+
+    return true;
+}
+
+
 // Add a tilemap
 bool ass_add_tilemap(const char* path, const char* name) {
 
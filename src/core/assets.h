@@ -10,12 +10,16 @@
 
 // Macro for loading and checking if fails
 #define BITMAP(path, name) !ass_add_bitmap(path, name)
+#define BITMAP_MIRRORED(path, name) !ass_add_bitmap_mirrored(path, name)
 
 // Initialize
 void init_assets();
 
 // Add a bitmap
 bool ass_add_bitmap(const char* path, const char* name);
+// Add a bitmap with a mirrored copy (for
+// bitmaps that are drawn flipped)
+bool ass_add_bitmap_mirrored(const char* path, const char* name);
 // Add a tilemap
 bool ass_add_tilemap(const char* path, const char* name);
 
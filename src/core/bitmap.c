@@ -41,6 +41,7 @@ Bitmap* create_bitmap(uint16 w, uint16 h, uint8* data) {
     // Store size
     bmp->width = w;
     bmp->height = h;
+    bmp->mirror = NULL;
 
     return bmp;
 }
@@ -82,6 +83,35 @@ Bitmap* load_bitmap(const char* path) {
 }
 
 
+// Create a horizontally mirrored copy of the pixels
+bool bitmap_create_mirror(Bitmap* bmp) {
+
+    uint16 x, y;
+    uint16 row = 0;
+
+    if(bmp->mirror != NULL)
+        return true;
+
+    bmp->mirror = (uint8*)malloc(sizeof(uint8) * bmp->width * bmp->height);
+    if(bmp->mirror == NULL) {
+
+        THROW_MALLOC_ERR;
+        return false;
+    }
+
+    for(y = 0; y < bmp->height; ++ y) {
+
+        for(x = 0; x < bmp->width; ++ x) {
+
+            bmp->mirror[row + x] = bmp->data[row + bmp->width-1 - x];
+        }
+        row += bmp->width;
+    }
+
+    return true;
+}
+
+
 // Destroy a bitmap
 void destroy_bitmap(Bitmap* bmp) {
 
@@ -93,6 +123,10 @@ void destroy_bitmap(Bitmap* bmp) {
         
         free(bmp->data);
     }
+    if(bmp->mirror != NULL) {
+
+        free(bmp->mirror);
+    }
     // Free bitmap
     free(bmp);
 }
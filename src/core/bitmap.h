@@ -15,6 +15,9 @@ typedef struct {
 
     // Pixels
     uint8* data;
+    // Horizontally mirrored pixels (NULL
+    // if not created)
+    uint8* mirror;
 
 } Bitmap;
 
@@ -24,6 +27,10 @@ Bitmap* create_bitmap(uint16 w, uint16 h, uint8* data);
 // Load a bitmap
 Bitmap* load_bitmap(const char* path);
 
+// Create a horizontally mirrored copy of the
+// pixels, used when drawing flipped
+bool bitmap_create_mirror(Bitmap* bmp);
+
 // Destroy a bitmap
 void destroy_bitmap(Bitmap* bmp);
 
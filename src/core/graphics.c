@@ -26,6 +26,9 @@
 
 // Framebuffer
 static uint8* frame;
+// Has the framebuffer changed since
+// the last time it was drawn
+static bool frameChanged;
 
 // Framebuffer size
 static Vector2 frameDim;
@@ -48,6 +51,185 @@ static const long VGA_POS = 0xA0000000;
 static const long PALETTE_INDEX = 0x03c8;
 static const long PALETTE_DATA = 0x03c9;
 
+// Save-under buffer size & the maximum
+// amount of saved areas
+#define SAVE_UNDER_SIZE 12288
+#define SAVE_UNDER_MAX 4
+// Save-under buffer
+static uint8* saveBuffer;
+static uint16 saveUsed;
+// Saved areas
+static Rect saveAreas [SAVE_UNDER_MAX];
+static uint8 saveCount;
+
+// Text cache size & the longest string cached
+#define TEXT_CACHE_COUNT 8
+#define TEXT_CACHE_LENGTH 24
+// Cached string bitmap
+typedef struct {
+
+    Bitmap* font;
+    Bitmap* bmp;
+    char text [TEXT_CACHE_LENGTH+1];
+    uint16 time;
+
+} CachedText;
+// Text cache
+static CachedText textCache [TEXT_CACHE_COUNT];
+static uint16 textTime;
+
+// Darkness levels
+#define DARK_LEVELS 8
+// Palette indices for each darkness level
+static uint8 darkIndices [DARK_LEVELS] [256];
+// Current darkness level
+static uint8 darkness;
+
+
+
+// Widest row the 32-bit kernels handle
+#define WIDE_MAX_WIDTH 32
+
+
+// Copy rows with 32-bit stores. The width must be
+// a multiple of 4 and at most WIDE_MAX_WIDTH (tiles,
+// glyphs, the ship...). Rows that are not word
+// aligned are copied bytewise
+static void copy_rows_wide(uint8* dst, const uint8* src, 
+    uint16 srcPitch, int16 w, int16 h) {
+
+    uint32* d;
+    const uint32* s;
+    int16 words = w >> 2;
+    int16 y, i;
+
+    // Same alignment on every row, since the
+    // framebuffer width is a multiple of 4
+    if(((size_t)dst | (size_t)src | srcPitch) & 3) {
+
+        for(y = 0; y < h; ++ y) {
+
+            memcpy(dst, src, w);
+            dst += FB_WIDTH;
+            src += srcPitch;
+        }
+        return;
+    }
+
+    for(y = 0; y < h; ++ y) {
+
+        d = (uint32*)dst;
+        s = (const uint32*)src;
+        for(i = 0; i < words; ++ i)
+            d[i] = s[i];
+
+        dst += FB_WIDTH;
+        src += srcPitch;
+    }
+}
+
+
+// Fill rows with 32-bit stores to aligned addresses,
+// and bytes at the ends
+static void fill_rows_wide(uint8* dst, uint8 col, int16 w, int16 h) {
+
+    uint32 pattern = col * 0x01010101UL;
+    uint8* p;
+    uint32* d;
+    int16 head, words, tail;
+    int16 y, i;
+
+    // Same alignment on every row, since the
+    // framebuffer width is a multiple of 4
+    head = (int16)((4 - ((size_t)dst & 3)) & 3);
+    if(head > w) head = w;
+    words = (w - head) >> 2;
+    tail = (w - head) & 3;
+
+    for(y = 0; y < h; ++ y) {
+
+        p = dst;
+        for(i = 0; i < head; ++ i)
+            *(p ++) = col;
+
+        d = (uint32*)p;
+        for(i = 0; i < words; ++ i)
+            *(d ++) = pattern;
+
+        p = (uint8*)d;
+        for(i = 0; i < tail; ++ i)
+            *(p ++) = col;
+
+        dst += FB_WIDTH;
+    }
+}
+
+
+// Alpha key in every byte
+#define ALPHA_WORD 0xAAAAAAAAUL
+
+
+// Get a mask with 0xFF in the bytes of four
+// pixels that are not transparent
+static uint32 get_opaque_mask(uint32 pixels) {
+
+    // Bytes equal to the alpha become zero, and
+    // the high bit of t is set for the other bytes
+    uint32 x = pixels ^ ALPHA_WORD;
+    uint32 t = ((x & 0x7F7F7F7FUL) + 0x7F7F7F7FUL) | x;
+
+    return ((t & 0x80808080UL) >> 7) * 0xFF;
+}
+
+
+// Reverse the order of four pixels
+static uint32 reverse_pixels(uint32 p) {
+
+    return (p >> 24) | ((p >> 8) & 0xFF00UL) | 
+        ((p << 8) & 0xFF0000UL) | (p << 24);
+}
+
+
+// Draw a row of pixels with transparency, four
+// pixels at a time. If flipped, the source is
+// read backwards from src
+static void blit_masked_row(uint8* dst, const uint8* src, 
+    int16 w, bool flip) {
+
+    uint32 pixels, mask;
+    int16 x = 0;
+
+    for(; x + 4 <= w; x += 4) {
+
+        if(flip) {
+
+            pixels = reverse_pixels(*(const uint32*)(src - x - 3));
+        }
+        else {
+
+            pixels = *(const uint32*)(src + x);
+        }
+
+        mask = get_opaque_mask(pixels);
+        if(mask == 0xFFFFFFFFUL) {
+
+            *(uint32*)(dst + x) = pixels;
+        }
+        else if(mask != 0) {
+
+            *(uint32*)(dst + x) = 
+                (*(uint32*)(dst + x) & ~mask) | (pixels & mask);
+        }
+    }
+
+    // The remaining pixels
+    for(; x < w; ++ x) {
+
+        pixels = flip ? src[-x] : src[x];
+        if(pixels != ALPHA)
+            dst[x] = (uint8)pixels;
+    }
+}
 
 
 // Clip a rectangle
@@ -154,6 +336,22 @@ static uint8 get_dark_value(uint8 color, uint8 count) {
 }
 
 
+// Compute the palette indices for the darkness levels
+static void init_dark_tables() {
+
+    int16 i;
+    uint8 d;
+
+    for(d = 0; d < DARK_LEVELS; ++ d) {
+
+        for(i = 0; i < 256; ++ i) {
+
+            darkIndices[d][i] = get_dark_value((uint8)i, d);
+        }
+    }
+}
+
+
 // Set palette
 static void set_palette() {
 
@@ -179,6 +377,16 @@ int16 init_graphics() {
         return 1;
     }
 
+    // Create a save-under buffer
+    saveBuffer = (uint8*)malloc(sizeof(uint8)*SAVE_UNDER_SIZE);
+    if(saveBuffer == NULL) {
+
+        err_throw_no_param("Memory allocation error!");
+        return 1;
+    }
+    saveUsed = 0;
+    saveCount = 0;
+
     // Set defaults
     frameDim.x = FB_WIDTH;
     frameDim.y = FB_HEIGHT;
@@ -192,7 +400,9 @@ int16 init_graphics() {
     // Set video mode to 320x200 256 colors
     _setvideomode(_MRES256COLOR);
     // Set palette
+    init_dark_tables();
     set_palette();
+    darkness = 0;
 
     // Set default viewport
     viewport.x = 0;
@@ -215,6 +425,8 @@ void destroy_graphics() {
 
     // Free allocated data
     free(frame);
+    free(saveBuffer);
+    clear_text_cache();
 }
 
 
@@ -229,7 +441,18 @@ void vblank() {
 // Draw frame to the screen
 void draw_frame() {
 
+    // Nothing to copy
+    if(!frameChanged) return;
+
     memcpy((void*)VGA_POS, (const void*)frame, frameSize);
+    frameChanged = false;
+}
+
+
+// Has the frame changed since the last draw
+bool frame_changed() {
+
+    return frameChanged;
 }
 
 
@@ -237,6 +460,7 @@ void draw_frame() {
 void clear_screen(uint8 color) {
 
     memset(frame, color, frameSize);
+    frameChanged = true;
 }
 
 
@@ -323,8 +547,11 @@ void draw_line(int16 x1, int16 y1,
 
         // Put pixel
         if(y1 < endy && y1 >= viewport.y &&
-            x1 < endx && x1 >= viewport.x)
+            x1 < endx && x1 >= viewport.x) {
+
             frame[y1 * frameDim.x + x1] = color;
+            frameChanged = true;
+        }
         
         // Goal reached
         if (x1==x2 && y1==y2) 
@@ -350,15 +577,22 @@ void fill_rect(int16 dx, int16 dy,
     // Clip
     if(clipping && !clip_rect( &dx, &dy, &w, &h))
         return;
+    frameChanged = true;
 
-    // Draw
+    // Draw. Short rows are filled with word stores
+    // to avoid a memset call per row
     offset = frameDim.x*dy + dx;
+    if(w <= WIDE_MAX_WIDTH) {
+
+        fill_rows_wide(frame + offset, col, w, h);
+        return;
+    }
+
     for(y = dy; y < dy+h; ++ y) {
 
         memset(frame + offset, col, w);
         offset += frameDim.x;
     }
-
 }
 
 
@@ -375,6 +609,7 @@ void draw_rect(int16 dx, int16 dy,
     // Clip
     if(clipping && !clip_rect( &dx, &dy, &w, &h))
         return;
+    frameChanged = true;
 
     // Top line
     if(dy == oy) {
@@ -406,6 +641,85 @@ void draw_rect(int16 dx, int16 dy,
 }
 
 
+// Save the area under an overlay
+bool push_save_under(int16 dx, int16 dy, int16 w, int16 h) {
+
+    int16 y;
+    uint16 offset;
+    uint8* p;
+    Rect* r;
+
+    dx += tr.x;
+    dy += tr.y;
+
+    // Clip to the screen
+    if(dx < 0) { w += dx; dx = 0; }
+    if(dy < 0) { h += dy; dy = 0; }
+    if(dx+w > FB_WIDTH) w = FB_WIDTH-dx;
+    if(dy+h > FB_HEIGHT) h = FB_HEIGHT-dy;
+    if(w <= 0 || h <= 0) 
+        w = h = 0;
+
+    if(saveCount >= SAVE_UNDER_MAX || 
+       (uint16)(w*h) > SAVE_UNDER_SIZE - saveUsed) {
+
+        return false;
+    }
+
+    // Copy rows
+    p = saveBuffer + saveUsed;
+    offset = frameDim.x*dy + dx;
+    for(y = 0; y < h; ++ y) {
+
+        memcpy(p, frame + offset, w);
+        p += w;
+        offset += frameDim.x;
+    }
+
+    r = &saveAreas[saveCount ++];
+    r->x = dx;
+    r->y = dy;
+    r->w = w;
+    r->h = h;
+    saveUsed += w*h;
+
+    return true;
+}
+
+
+// Restore the latest saved area
+void pop_save_under() {
+
+    int16 y;
+    uint16 offset;
+    uint8* p;
+    Rect* r;
+
+    if(saveCount == 0) return;
+
+    r = &saveAreas[-- saveCount];
+    saveUsed -= r->w*r->h;
+
+    p = saveBuffer + saveUsed;
+    offset = frameDim.x*r->y + r->x;
+    for(y = 0; y < r->h; ++ y) {
+
+        memcpy(frame + offset, p, r->w);
+        p += r->w;
+        offset += frameDim.x;
+    }
+    frameChanged = true;
+}
+
+
+// Drop all the saved areas
+void clear_save_under() {
+
+    saveCount = 0;
+    saveUsed = 0;
+}
+
+
 // Draw a bitmap fast (= ignoring alpha)
 void draw_bitmap_fast(Bitmap* bmp, int16 dx, int16 dy) {
 
@@ -431,10 +745,21 @@ void draw_bitmap_region_fast(Bitmap* bmp,
     // Clip
     if(clipping && !clip(&sx, &sy, &sw, &sh, &dx, &dy, false))
         return;
+    frameChanged = true;
 
     // Copy horizontal lines
     offset = frameDim.x*dy + dx;
     boff = bmp->width*sy + sx;
+
+    // Common sizes (16x16 tiles, 8x8 glyphs, the 32x32
+    // ship) are copied with word stores
+    if((sw & 3) == 0 && sw <= WIDE_MAX_WIDTH) {
+
+        copy_rows_wide(frame + offset, bmp->data + boff, 
+            bmp->width, sw, sh);
+        return;
+    }
+
     for(y = dy; y < dy+sh; ++ y) {
 
         memcpy(frame + offset, bmp->data + boff, sw);
@@ -444,22 +769,116 @@ void draw_bitmap_region_fast(Bitmap* bmp,
 }
 
 
-// Draw text fast (ignoring alpha)
-void draw_text_fast(Bitmap* font, const char* text, 
-    int16 dx, int16 dy, int16 xoff, int16 yoff, bool center) {
+// Draw a character fast
+void draw_char_fast(Bitmap* font, uint8 c, int16 dx, int16 dy) {
 
-    uint16 len = strlen((const char*)text);
-    draw_substr_fast(font, text, dx, dy, xoff, yoff, 0, len, center);
+    int16 cw = font->width / 16;
+    int16 ch = cw;
+    uint16 offset;
+    uint16 boff;
+    int16 y;
+    int16 sx = (c % 16) * cw;
+    int16 sy = (c / 16) * ch;
+
+    dx += tr.x;
+    dy += tr.y;
+
+    // If the glyph is clipped, use the generic 
+    // path, otherwise copy it directly
+    if(clipping && 
+       (dx < viewport.x || dy < viewport.y ||
+        dx+cw >= viewport.x+viewport.w || 
+        dy+ch >= viewport.y+viewport.h)) {
+
+        draw_bitmap_region_fast(font, sx, sy, cw, ch, dx-tr.x, dy-tr.y);
+        return;
+    }
+    frameChanged = true;
+
+    offset = frameDim.x*dy + dx;
+    boff = font->width*sy + sx;
+    if((cw & 3) == 0 && cw <= WIDE_MAX_WIDTH) {
+
+        copy_rows_wide(frame + offset, font->data + boff, 
+            font->width, cw, ch);
+        return;
+    }
+
+    for(y = 0; y < ch; ++ y) {
+
+        memcpy(frame + offset, font->data + boff, cw);
+        offset += frameDim.x;
+        boff += font->width;
+    }
 }
 
 
-// Draw substring fast
-void draw_substr_fast(Bitmap* font, const char* text, 
+// Get a cached bitmap of a string (one line only), or
+// render one. Returns NULL if the string cannot be cached
+static Bitmap* get_text_bitmap(Bitmap* font, const char* text, 
+    uint16 len) {
+
+    uint16 cw = font->width / 16;
+    uint16 ch = cw;
+    uint16 i, y;
+    uint8 c;
+    uint8* dst;
+    const uint8* src;
+    CachedText* t = NULL;
+
+    if(len == 0 || len > TEXT_CACHE_LENGTH)
+        return NULL;
+
+    // Find the string, or the least recently used slot
+    for(i = 0; i < TEXT_CACHE_COUNT; ++ i) {
+
+        if(textCache[i].bmp != NULL && textCache[i].font == font &&
+           strcmp(textCache[i].text, text) == 0) {
+
+            textCache[i].time = ++ textTime;
+            return textCache[i].bmp;
+        }
+
+        if(t == NULL || textCache[i].bmp == NULL || 
+           (t->bmp != NULL && textCache[i].time < t->time)) {
+
+            t = &textCache[i];
+        }
+    }
+
+    // Render the string
+    if(t->bmp != NULL)
+        destroy_bitmap(t->bmp);
+    t->bmp = create_bitmap(len*cw, ch, NULL);
+    if(t->bmp == NULL)
+        return NULL;
+
+    for(i = 0; i < len; ++ i) {
+
+        c = text[i];
+        dst = t->bmp->data + i*cw;
+        src = font->data + (c / 16)*ch*font->width + (c % 16)*cw;
+        for(y = 0; y < ch; ++ y) {
+
+            memcpy(dst, src, cw);
+            dst += t->bmp->width;
+            src += font->width;
+        }
+    }
+
+    t->font = font;
+    strcpy(t->text, text);
+    t->time = ++ textTime;
+
+    return t->bmp;
+}
+
+
+// Draw substring fast, the length known
+static void draw_substr_len(Bitmap* font, const char* text, uint16 len,
     int16 dx, int16 dy, int16 xoff, int16 yoff, 
     uint16 start, uint16 end,
     bool center) {
-    
-    uint16 len = strlen((const char*)text);
 
     int16 x = dx;
     int16 y = dy;
@@ -467,7 +886,6 @@ void draw_substr_fast(Bitmap* font, const char* text,
     uint16 ch = cw;
     uint16 i;
     uint8 c;
-    int16 sx, sy;
 
     end = min_int16(len, end);
 
@@ -491,14 +909,10 @@ void draw_substr_fast(Bitmap* font, const char* text,
             continue;
         }
 
+        // Draw char
         if(i >= start) {
 
-            sx = c % 16;
-            sy = c / 16;
-
-            // Draw char
-            draw_bitmap_region_fast(font, sx*cw, sy*ch, 
-                cw, ch, x, y);
+            draw_char_fast(font, c, x, y);
         }
 
         x += cw + xoff;
@@ -506,6 +920,57 @@ void draw_substr_fast(Bitmap* font, const char* text,
 }
 
 
+// Draw text fast (ignoring alpha)
+void draw_text_fast(Bitmap* font, const char* text, 
+    int16 dx, int16 dy, int16 xoff, int16 yoff, bool center) {
+
+    uint16 len = strlen((const char*)text);
+    Bitmap* bmp;
+
+    // Single lines without extra spacing are
+    // drawn from the string cache
+    if(xoff == 0 && memchr(text, '\n', len) == NULL) {
+
+        bmp = get_text_bitmap(font, text, len);
+        if(bmp != NULL) {
+
+            draw_bitmap_fast(bmp, 
+                center ? dx - (int16)bmp->width/2 : dx, dy);
+            return;
+        }
+    }
+
+    draw_substr_len(font, text, len, dx, dy, xoff, yoff, 0, len, center);
+}
+
+
+// Draw substring fast
+void draw_substr_fast(Bitmap* font, const char* text, 
+    int16 dx, int16 dy, int16 xoff, int16 yoff, 
+    uint16 start, uint16 end,
+    bool center) {
+
+    draw_substr_len(font, text, strlen((const char*)text), 
+        dx, dy, xoff, yoff, start, end, center);
+}
+
+
+// Clear the string bitmap cache
+void clear_text_cache() {
+
+    int16 i;
+
+    for(i = 0; i < TEXT_CACHE_COUNT; ++ i) {
+
+        if(textCache[i].bmp != NULL) {
+
+            destroy_bitmap(textCache[i].bmp);
+            textCache[i].bmp = NULL;
+        }
+    }
+}
+
+
 // Draw a bitmap
 void draw_bitmap(Bitmap* bmp, int16 x, int16 y,
     bool flip) {
@@ -532,10 +997,22 @@ void draw_bitmap_region_skip(Bitmap* bmp,
     uint16 offset;
     uint16 boff;
     uint8 pixel;
-    int16 dir = flip ? -1 : 1;
+    int16 dir;
+    const uint8* data;
 
     if(bmp == NULL) return;
 
+    // Draw from the mirrored pixels, if any,
+    // so that we do not need to flip
+    data = bmp->data;
+    if(flip && bmp->mirror != NULL) {
+
+        data = bmp->mirror;
+        sx = bmp->width - sx - sw;
+        flip = false;
+    }
+    dir = flip ? -1 : 1;
+
     // Translate
     dx += tr.x;
     dy += tr.y;
@@ -543,15 +1020,29 @@ void draw_bitmap_region_skip(Bitmap* bmp,
     // Clip
     if(clipping && !clip(&sx, &sy, &sw, &sh, &dx, &dy, flip))
         return;
+    frameChanged = true;
 
     // Draw pixels
     offset = frameDim.x*dy + dx;
     boff = bmp->width*sy + sx + (flip ? (sw-1) : 0);
+
+    // Without skipping, four pixels at a time
+    if(skip == 0) {
+
+        for(y = 0; y < sh; ++ y) {
+
+            blit_masked_row(frame + offset, data + boff, sw, flip);
+            boff += bmp->width;
+            offset += frameDim.x;
+        }
+        return;
+    }
+
     for(y = 0; y < sh; ++ y) {
 
         for(x = 0; x < sw; ++ x) {
 
-            pixel = bmp->data[boff];
+            pixel = data[boff];
             // Check if not alpha pixel
             // (i.e not transparent)
             if(pixel != ALPHA &&
@@ -573,22 +1064,33 @@ void draw_bitmap_region_skip(Bitmap* bmp,
 void set_palette_darkness(uint8 d) {
 
     int16 i = 0;
+    int16 next = -1;
     uint8 j;
+    const uint8* old;
+    const uint8* indices;
 
-    if(d == 0) {
-
-        set_palette();
+    if(d >= DARK_LEVELS)
+        d = DARK_LEVELS-1;
+    if(d == darkness) 
         return;
-    }
 
-    // Generate simple palette
-    outp(PALETTE_INDEX,0);
+    // Only write the entries that change (the
+    // DAC index is set again after a gap)
+    old = darkIndices[darkness];
+    indices = darkIndices[d];
     for(i = 0; i < 256 ;  ++ i) {
 
-        j = get_dark_value(i, d);
+        j = indices[i];
+        if(j == old[i]) 
+            continue;
+
+        if(i != next)
+            outp(PALETTE_INDEX, i);
 
         outp(PALETTE_DATA, PALETTE[j*3]/4);
         outp(PALETTE_DATA, PALETTE[j*3 +1]/4);
         outp(PALETTE_DATA, PALETTE[j*3 +2]/4);
+        next = i+1;
     }
+    darkness = d;
 }
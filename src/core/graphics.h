@@ -16,9 +16,12 @@ void destroy_graphics();
 // Wait for vblank
 void vblank();
 
-// Draw frame to the screen
+// Draw frame to the screen (if changed)
 void draw_frame();
 
+// Has the frame changed since the last draw
+bool frame_changed();
+
 // Clear screen
 void clear_screen(uint8 color);
 
@@ -51,6 +54,15 @@ void fill_rect(int16 x, int16 y,
 void draw_rect(int16 x, int16 y, 
     int16 w, int16 h, uint8 col);
 
+// Save the area under an overlay, so that it can
+// be restored when the overlay is closed. Returns
+// false if there is no room
+bool push_save_under(int16 x, int16 y, int16 w, int16 h);
+// Restore the latest saved area
+void pop_save_under();
+// Drop all the saved areas
+void clear_save_under();
+
 // Draw a bitmap fast (= ignoring alpha)
 void draw_bitmap_fast(Bitmap* bmp, int16 x, int16 y);
 
@@ -58,6 +70,9 @@ void draw_bitmap_fast(Bitmap* bmp, int16 x, int16 y);
 void draw_bitmap_region_fast(Bitmap* bmp, 
     int16 sx, int16 sy, int16 sw, int16 sh, int16 dx, int16 dy);
 
+// Draw a character fast (ignoring alpha)
+void draw_char_fast(Bitmap* font, uint8 c, int16 x, int16 y);
+
 // Draw text fast (ignoring alpha)
 void draw_text_fast(Bitmap* font, const char* text, 
     int16 x, int16 y, int16 xoff, int16 yoff, bool center);
@@ -68,6 +83,10 @@ void draw_substr_fast(Bitmap* font, const char* text,
     uint16 start, uint16 end,
     bool center);
 
+// Clear the string bitmap cache (call if
+// a font is destroyed)
+void clear_text_cache();
+
 // Draw a bitmap
 void draw_bitmap(Bitmap* bmp, int16 x, int16 y,
     bool flip);    
@@ -4,6 +4,7 @@
 #include "input.h"
 
 #include "types.h"
+#include "timer.h"
 
 #include <dos.h>
 #include <conio.h>
@@ -17,6 +18,19 @@
 #define KEY_BUFFER_SIZE 0x60
 // Maximum amount of "buttons"
 #define MAX_BUTTONS 8
+// Event ring size (a power of two)
+#define EVENT_RING_SIZE 32
+// Extended key flag in the event codes
+#define EXT_KEY_FLAG 0x80
+
+// Key event
+typedef struct {
+
+    uint8 code;
+    uint8 makeBreak;
+    uint32 time;
+
+} KeyEvent;
 
 // Arrow keycodes
 static const short ARROW_KEY_CODES[] = {
@@ -28,10 +42,9 @@ static uint8 normalKeys[KEY_BUFFER_SIZE];
 // Extended keys
 static uint8 extKeys[KEY_BUFFER_SIZE];
 
-// Old key states (normal)
-static uint8 oldNormals[KEY_BUFFER_SIZE];
-// Old key states (extended)
-static uint8 oldExt[KEY_BUFFER_SIZE];
+// Keys changed in the current update
+static bool normalChanged[KEY_BUFFER_SIZE];
+static bool extChanged[KEY_BUFFER_SIZE];
 // Read states (normal)
 static bool normalRead[KEY_BUFFER_SIZE];
 // Read states (extended)
@@ -43,6 +56,17 @@ static void far interrupt (*oldHandler)(void);
 // "Buttons"
 static int16 buttons [MAX_BUTTONS];
 
+// Event ring. Only the interrupt handler writes
+// the head and only input_update writes the tail
+static KeyEvent events [EVENT_RING_SIZE];
+static volatile uint8 eventHead;
+static volatile uint8 eventTail;
+// Events lost because the ring was full
+static volatile uint16 eventsLost;
+
+// Time of the latest key press
+static uint32 lastPressTime;
+
 
 // Keyboard interruption
 static void far interrupt handler() {
@@ -51,6 +75,8 @@ static void far interrupt handler() {
     uint8 rawcode;
     uint8 makeBreak;
     int16 scancode;
+    uint8 code = 0xFF;
+    uint8 next;
 
     rawcode = inp(0x60); 
     makeBreak = !(rawcode & 0x80); 
@@ -60,11 +86,7 @@ static void far interrupt handler() {
 
         if(scancode < 0x60) {
 
-            oldExt[scancode] = extKeys[scancode];
-            extKeys[scancode] = makeBreak;
-
-            if(extKeys[scancode] != oldExt[scancode])
-                extRead[scancode] = false;
+            code = (uint8)scancode | EXT_KEY_FLAG;
         }
         buffer = 0;
 
@@ -81,11 +103,24 @@ static void far interrupt handler() {
     } 
     else if (scancode < 0x60) {
 
-        oldNormals[scancode] = normalKeys[scancode];
-        normalKeys[scancode] = makeBreak;
+        code = (uint8)scancode;
+    }
+
+    // Push to the ring
+    if(code != 0xFF) {
+
+        next = (eventHead+1) & (EVENT_RING_SIZE-1);
+        if(next == eventTail) {
+
+            ++ eventsLost;
+        }
+        else {
 
-        if(normalKeys[scancode] != oldNormals[scancode])
-            normalRead[scancode] = false;
+            events[eventHead].code = code;
+            events[eventHead].makeBreak = makeBreak;
+            events[eventHead].time = timer_get_ticks_isr();
+            eventHead = next;
+        }
     }
 
     outp(0x20, 0x20);
@@ -121,11 +156,15 @@ void init_input() {
     // Set defaults
     for(i=0; i < KEY_BUFFER_SIZE; ++ i) {
 
-        oldNormals[i] = 255;
-        oldExt[i] = 255;
-        normalRead[i] = false;
-        extRead[i] = false;
+        normalKeys[i] = StateUp;
+        extKeys[i] = StateUp;
+        normalRead[i] = true;
+        extRead[i] = true;
     }
+    eventHead = 0;
+    eventTail = 0;
+    eventsLost = 0;
+    lastPressTime = 0;
     for(i=0; i < MAX_BUTTONS; ++ i) {
 
         buttons[i] = 0;
@@ -145,6 +184,73 @@ void destroy_input() {
 }
 
 
+// Update (drain the event ring)
+void input_update() {
+
+    int16 i;
+    KeyEvent* e;
+    uint8* keys;
+    bool* read;
+    bool* changed;
+    uint8 id;
+
+    for(i=0; i < KEY_BUFFER_SIZE; ++ i) {
+
+        normalChanged[i] = false;
+        extChanged[i] = false;
+    }
+
+    while(eventTail != eventHead) {
+
+        e = &events[eventTail];
+        id = e->code & ~EXT_KEY_FLAG;
+        if(e->code & EXT_KEY_FLAG) {
+
+            keys = extKeys;
+            read = extRead;
+            changed = extChanged;
+        }
+        else {
+
+            keys = normalKeys;
+            read = normalRead;
+            changed = normalChanged;
+        }
+
+        if(keys[id] != e->makeBreak) {
+
+            // Already changed during this update, leave
+            // the rest to the next one so that nothing is lost
+            if(changed[id])
+                break;
+
+            keys[id] = e->makeBreak;
+            read[id] = false;
+            changed[id] = true;
+
+            if(e->makeBreak)
+                lastPressTime = e->time;
+        }
+
+        eventTail = (eventTail+1) & (EVENT_RING_SIZE-1);
+    }
+}
+
+
+// Get the time of the latest key press
+uint32 input_get_press_time() {
+
+    return lastPressTime;
+}
+
+
+// Get the number of lost key events
+uint16 input_get_lost_events() {
+
+    return eventsLost;
+}
+
+
 // Get key state
 int16 input_get_key(int16 id) {
 
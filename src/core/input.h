@@ -30,6 +30,17 @@ void init_input();
 // Destroy
 void destroy_input();
 
+// Update (drain the key event ring, call
+// once per frame)
+void input_update();
+
+// Get the time of the latest key press
+// (in timer ticks)
+uint32 input_get_press_time();
+
+// Get the number of lost key events
+uint16 input_get_lost_events();
+
 // Get key state
 int16 input_get_key(int16 id);
 // Get arrow key state
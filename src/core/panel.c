@@ -0,0 +1,290 @@
+// Bordered panels, composed once
+// per size & cached
+// (c) 2019 Jani Nykänen
+
+#include "panel.h"
+
+#include "graphics.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Cache size
+#define PANEL_CACHE_COUNT 8
+#define PANEL_CACHE_BYTES 49152U
+
+// Frame tile size
+#define TILE_W 8
+#define TILE_H 8
+
+// Colors
+static const uint8 SHADOW_COLOR = 51;
+static const uint8 BOX_OUTER_COLOR = 146;
+static const uint8 BOX_INNER_COLOR = 255;
+
+// Cached panel
+typedef struct {
+
+    Bitmap* bmp;
+    // Key
+    Bitmap* tiles;
+    int16 w, h;
+    uint8 color;
+    // Last used
+    uint16 time;
+
+} Panel;
+
+// Cache
+static Panel cache [PANEL_CACHE_COUNT];
+static uint16 cacheBytes = 0;
+static uint16 cacheTime = 0;
+
+
+// Get the frame tile position
+static void get_frame_tile(int16 x, int16 y, int16 w, int16 h,
+    int16* sx, int16* sy) {
+
+    *sx = x == 0 ? 0 : (x == w-1 ? 16 : 8);
+    *sy = y == 0 ? 0 : (y == h-1 ? 16 : 8);
+}
+
+
+// Remove a panel from the cache
+static void remove_panel(Panel* p) {
+
+    cacheBytes -= p->bmp->width * p->bmp->height;
+    destroy_bitmap(p->bmp);
+    p->bmp = NULL;
+}
+
+
+// Find a cached panel
+static Panel* find_panel(Bitmap* tiles, int16 w, int16 h, uint8 c) {
+
+    int16 i;
+    Panel* p;
+
+    for(i = 0; i < PANEL_CACHE_COUNT; ++ i) {
+
+        p = &cache[i];
+        if(p->bmp != NULL && p->tiles == tiles &&
+           p->w == w && p->h == h && p->color == c) {
+
+            p->time = ++ cacheTime;
+            return p;
+        }
+    }
+    return NULL;
+}
+
+
+// Add a panel bitmap to the cache, removing the
+// least recently used ones if needed. Returns NULL
+// if the panel does not fit
+static Panel* add_panel(Bitmap* tiles, int16 w, int16 h, uint8 c,
+    uint16 bw, uint16 bh) {
+
+    uint32 size = (uint32)bw * bh;
+    int16 i;
+    Panel* p;
+    Panel* slot;
+
+    if(size > PANEL_CACHE_BYTES)
+        return NULL;
+
+    while(true) {
+
+        // Find a free slot & the oldest panel
+        slot = NULL;
+        p = NULL;
+        for(i = 0; i < PANEL_CACHE_COUNT; ++ i) {
+
+            if(cache[i].bmp == NULL) {
+
+                if(slot == NULL) slot = &cache[i];
+            }
+            else if(p == NULL || cache[i].time < p->time) {
+
+                p = &cache[i];
+            }
+        }
+
+        if(slot != NULL && cacheBytes + size <= PANEL_CACHE_BYTES)
+            break;
+
+        remove_panel(p);
+    }
+
+    slot->bmp = create_bitmap(bw, bh, NULL);
+    if(slot->bmp == NULL)
+        return NULL;
+
+    slot->tiles = tiles;
+    slot->w = w;
+    slot->h = h;
+    slot->color = c;
+    slot->time = ++ cacheTime;
+    cacheBytes += (uint16)size;
+
+    return slot;
+}
+
+
+// Draw a framed panel tile by tile (if it cannot be cached)
+static void draw_frame_tiles(Bitmap* tiles,
+    int16 dx, int16 dy, int16 w, int16 h, uint8 c) {
+
+    int16 x, y;
+    int16 sx, sy;
+
+    for(y = 0; y < h; ++ y) {
+
+        for(x = 0; x < w; ++ x) {
+
+            // Skip, if empty
+            if(x == 1 && y > 0 && y < h-1)
+                x = w-1;
+
+            get_frame_tile(x, y, w, h, &sx, &sy);
+            draw_bitmap_region_fast(tiles, sx, sy, 
+                TILE_W, TILE_H, dx+x*TILE_W, dy+y*TILE_H);
+        }
+    }
+
+    // Fill
+    fill_rect(dx+TILE_W, dy+TILE_H,
+        (w-2)*TILE_W, (h-2)*TILE_H, c);
+}
+
+
+// Compose a framed panel
+static void compose_frame(Bitmap* bmp, Bitmap* tiles, 
+    int16 w, int16 h, uint8 c) {
+
+    int16 x, y, row;
+    int16 sx, sy;
+    uint8* dst;
+    const uint8* src;
+
+    for(y = 0; y < h; ++ y) {
+
+        for(x = 0; x < w; ++ x) {
+
+            dst = bmp->data + (y*TILE_H)*bmp->width + x*TILE_W;
+
+            // Interior
+            if(x > 0 && x < w-1 && y > 0 && y < h-1) {
+
+                for(row = 0; row < TILE_H; ++ row) {
+
+                    memset(dst, c, TILE_W);
+                    dst += bmp->width;
+                }
+                continue;
+            }
+
+            get_frame_tile(x, y, w, h, &sx, &sy);
+            src = tiles->data + sy*tiles->width + sx;
+            for(row = 0; row < TILE_H; ++ row) {
+
+                memcpy(dst, src, TILE_W);
+                dst += bmp->width;
+                src += tiles->width;
+            }
+        }
+    }
+}
+
+
+// Compose a box
+static void compose_box(Bitmap* bmp) {
+
+    int16 y;
+    uint8* dst = bmp->data;
+    uint16 w = bmp->width;
+
+    for(y = 0; y < bmp->height; ++ y) {
+
+        // Outer & inner border rows
+        if(y == 0 || y == bmp->height-1) {
+
+            memset(dst, BOX_OUTER_COLOR, w);
+        }
+        else if(y == 1 || y == bmp->height-2) {
+
+            dst[0] = dst[w-1] = BOX_OUTER_COLOR;
+            memset(dst+1, BOX_INNER_COLOR, w-2);
+        }
+        else {
+
+            dst[0] = dst[w-1] = BOX_OUTER_COLOR;
+            dst[1] = dst[w-2] = BOX_INNER_COLOR;
+            memset(dst+2, 0, w-4);
+        }
+        dst += w;
+    }
+}
+
+
+// Draw a framed panel
+void panel_draw_frame(Bitmap* tiles, 
+    int16 dx, int16 dy, int16 w, int16 h, uint8 c) {
+
+    Panel* p = find_panel(tiles, w, h, c);
+    if(p == NULL) {
+
+        p = add_panel(tiles, w, h, c, w*TILE_W, h*TILE_H);
+        if(p != NULL)
+            compose_frame(p->bmp, tiles, w, h, c);
+    }
+
+    // Draw the panel
+    if(p != NULL)
+        draw_bitmap_fast(p->bmp, dx, dy);
+    else
+        draw_frame_tiles(tiles, dx, dy, w, h, c);
+
+    // Draw shadows
+    fill_rect(dx + w*TILE_W, dy+TILE_H, 
+        TILE_W, h*TILE_H, SHADOW_COLOR);
+    fill_rect(dx + TILE_W, dy + h*TILE_H, 
+        (w-1)*TILE_W, TILE_H, SHADOW_COLOR);
+}
+
+
+// Draw a box
+void panel_draw_box(int16 x, int16 y, int16 w, int16 h) {
+
+    Panel* p = find_panel(NULL, w, h, 0);
+    if(p == NULL) {
+
+        p = add_panel(NULL, w, h, 0, w+4, h+4);
+        if(p != NULL)
+            compose_box(p->bmp);
+    }
+
+    if(p != NULL) {
+
+        draw_bitmap_fast(p->bmp, x-2, y-2);
+        return;
+    }
+
+    fill_rect(x-2, y-2, w+4, h+4, BOX_OUTER_COLOR);
+    fill_rect(x-1, y-1, w+2, h+2, BOX_INNER_COLOR);
+    fill_rect(x, y, w, h, 0);
+}
+
+
+// Clear the panel cache
+void panel_clear_cache() {
+
+    int16 i;
+
+    for(i = 0; i < PANEL_CACHE_COUNT; ++ i) {
+
+        if(cache[i].bmp != NULL)
+            remove_panel(&cache[i]);
+    }
+    cacheBytes = 0;
+}
@@ -0,0 +1,25 @@
+// Bordered panels, composed once
+// per size & cached
+// (c) 2019 Jani Nykänen
+
+#ifndef __PANEL__
+#define __PANEL__
+
+#include "types.h"
+#include "bitmap.h"
+
+// Draw a panel framed with 8x8 tiles from a 3x3 tile
+// frame bitmap (w, h in tiles), filled with color c,
+// plus a shadow
+void panel_draw_frame(Bitmap* tiles, 
+    int16 dx, int16 dy, int16 w, int16 h, uint8 c);
+
+// Draw a black box with a two-pixel border
+// around the area (x, y, w, h)
+void panel_draw_box(int16 x, int16 y, int16 w, int16 h);
+
+// Clear the panel cache (call when a frame
+// bitmap is destroyed)
+void panel_clear_cache();
+
+#endif // __PANEL__
@@ -0,0 +1,119 @@
+// High resolution timer
+// (c) 2019 Jani Nykänen
+
+#include "timer.h"
+
+#include <conio.h>
+#include <i86.h>
+
+// BIOS tick counter position
+static const long BIOS_TICKS_POS = 0x0040006C;
+
+// BIOS ticks per day (the counter is reset
+// at midnight)
+static const uint32 BIOS_TICKS_PER_DAY = 0x1800B0L;
+
+// PIT ports
+static const long PIT_CONTROL = 0x43;
+static const long PIT_COUNTER = 0x40;
+
+// Previous time (to keep the time monotonic)
+static uint32 oldTicks;
+// Previous BIOS tick count & the BIOS ticks
+// of the days passed
+static uint32 oldBios;
+static uint32 dayTicks;
+
+
+// Initialize
+void init_timer() {
+
+    // Set channel 0 to mode 2 (rate generator) with
+    // the default divisor. The BIOS clock rate stays the
+    // same, but the counter now counts down linearly
+    _disable();
+    outp(PIT_CONTROL, 0x34);
+    outp(PIT_COUNTER, 0);
+    outp(PIT_COUNTER, 0);
+    _enable();
+
+    oldTicks = 0;
+    oldBios = *(volatile uint32*)BIOS_TICKS_POS;
+    dayTicks = 0;
+}
+
+
+// Destroy
+void destroy_timer() {
+
+    // Back to mode 3 (square wave)
+    _disable();
+    outp(PIT_CONTROL, 0x36);
+    outp(PIT_COUNTER, 0);
+    outp(PIT_COUNTER, 0);
+    _enable();
+}
+
+
+// Read the PIT counter & the BIOS tick count. 
+// Interrupts must be disabled
+static uint32 read_ticks(uint32* bios) {
+
+    uint8 lo, hi;
+
+    // Latch the counter & read it with the BIOS
+    // tick count
+    outp(PIT_CONTROL, 0);
+    lo = (uint8)inp(PIT_COUNTER);
+    hi = (uint8)inp(PIT_COUNTER);
+    *bios = *(volatile uint32*)BIOS_TICKS_POS;
+
+    // The counter counts down from 65536
+    return (uint16)(0 - (((uint16)hi << 8) | lo));
+}
+
+
+// Get time in timer ticks
+uint32 timer_get_ticks() {
+
+    uint32 bios;
+    uint32 ticks;
+
+    _disable();
+
+    ticks = read_ticks(&bios);
+
+    // Midnight passed, the BIOS count starts
+    // from zero again
+    if(bios < oldBios)
+        dayTicks += BIOS_TICKS_PER_DAY;
+    oldBios = bios;
+
+    ticks += (bios + dayTicks) << 16;
+
+    // If the counter wrapped before the BIOS tick
+    // was handled, the time seems to go backwards
+    if((int32)(ticks - oldTicks) < 0)
+        ticks = oldTicks;
+    oldTicks = ticks;
+
+    _enable();
+
+    return ticks;
+}
+
+
+// Get time in timer ticks in an interrupt handler
+uint32 timer_get_ticks_isr() {
+
+    uint32 bios;
+    uint32 ticks = read_ticks(&bios);
+    uint32 days = dayTicks;
+
+    // Midnight passed, but the main loop has
+    // not noticed it yet
+    if(bios < oldBios)
+        days += BIOS_TICKS_PER_DAY;
+
+    return ticks + ((bios + days) << 16);
+}
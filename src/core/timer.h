@@ -0,0 +1,26 @@
+// High resolution timer
+// (c) 2019 Jani Nykänen
+
+#ifndef __TIMER__
+#define __TIMER__
+
+#include "types.h"
+
+// Timer ticks per second
+#define TIMER_FREQ 1193182L
+
+// Initialize
+void init_timer();
+
+// Destroy
+void destroy_timer();
+
+// Get time in timer ticks (wraps around after
+// about an hour). Main loop only, since the time
+// is kept monotonic here
+uint32 timer_get_ticks();
+// Get time in timer ticks in an interrupt handler (leaves
+// the interrupt flag alone & is not kept monotonic)
+uint32 timer_get_ticks_isr();
+
+#endif // __TIMER__
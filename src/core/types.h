@@ -17,8 +17,24 @@ typedef unsigned char  uint8;
 typedef signed char  int8;
 typedef unsigned short uint16;
 typedef signed short   int16;
+// Long is 32 bits only on the DOS target, so
+// other compilers (the host tests) get the 
+// fixed-size types
+#ifdef __WATCOMC__
+typedef unsigned long  uint32;
+typedef signed long    int32;
+#else
+#include <stdint.h>
+typedef uint32_t uint32;
+typedef int32_t  int32;
+#endif
+typedef unsigned long long uint64;
 typedef bool boolean;
 
+// The word kernels in graphics.c depend on these
+typedef char _UINT32_SIZE_CHECK [sizeof(uint32) == 4 ? 1 : -1];
+typedef char _UINT64_SIZE_CHECK [sizeof(uint64) == 8 ? 1 : -1];
+
 // 2-component vectors
 typedef struct {
     
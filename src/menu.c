@@ -4,6 +4,7 @@
 #include "menu.h"
 
 #include "core/graphics.h"
+#include "core/panel.h"
 #include "core/assets.h"
 #include "core/input.h"
 #include "core/mathext.h"
@@ -32,6 +33,8 @@ Menu create_menu(uint8 escAction) {
     m.active = false;
     m.width = 0;
     m.redraw = true;
+    m.saved = false;
+    m.saveFailed = false;
     m.escAction = escAction;
 
     return m;
@@ -108,10 +111,15 @@ void menu_draw(Menu* m, int16 dx, int16 dy) {
     x = dx - w/2;
     y = dy - h/2;
 
+    // Save the area under the menu
+    if(!m->saved && !m->saveFailed) {
+
+        m->saved = push_save_under(x-2, y-2, w+4, h+4);
+        m->saveFailed = !m->saved;
+    }
+
     // Draw box
-    fill_rect(x-2, y-2, w+4, h+4, 146);
-    fill_rect(x-1, y-1, w+2, h+2, 255);
-    fill_rect(x, y, w, h, 0);
+    panel_draw_box(x, y, w, h);
 
     // Draw text
     for(i = 0; i < m->buttonCount; ++ i) {
@@ -131,5 +139,23 @@ void menu_activate(Menu* m, int16 cpos) {
 
     m->active = true;
     m->redraw = true;
+    m->saved = false;
+    m->saveFailed = false;
     m->cpos = cpos < 0 ? m->cpos : cpos;
 }
+
+
+// Deactivate
+boolean menu_deactivate(Menu* m) {
+
+    boolean restored = m->saved;
+
+    if(m->saved) {
+
+        pop_save_under();
+        m->saved = false;
+    }
+    m->active = false;
+
+    return restored;
+}
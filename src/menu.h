@@ -26,6 +26,11 @@ typedef struct {
 
     boolean active;
     boolean redraw;
+    // Is the area under the menu saved
+    boolean saved;
+    // Did saving fail (not retried until
+    // activated again)
+    boolean saveFailed;
 
     // Bitmaps
     Bitmap* bmpFont;
@@ -50,4 +55,9 @@ void menu_draw(Menu* m, int16 dx, int16 dy);
 // Activate
 void menu_activate(Menu* m, int16 cpos);
 
+// Deactivate & restore the area under the menu.
+// Returns false if it could not be restored 
+// (and must be redrawn)
+boolean menu_deactivate(Menu* m);
+
 #endif // __MENU__
@@ -48,12 +48,14 @@ static void boulder_move(Boulder* b, Player* pl, Stage* s, int16 steps) {
                 b->target.x = b->pos.x+dir.x;
                 b->target.y = b->pos.y+dir.y;
 
-                // Check if not a free tile
-                if(b->target.x < 1 || b->target.x >= s->width-1 ||
-                    b->target.y < 1 || b->target.y >= s->height-1 ||
+                // Check if not a free tile (black holes
+                // go through anything but the borders)
+                if( (b->type == 2 && 
+                     (b->target.x < 1 || b->target.x >= s->width-1 ||
+                      b->target.y < 1 || b->target.y >= s->height-1)) ||
                     (b->type != 2 &&
-                     stage_get_solid_data(s, b->target.x, b->target.y) > 0 &&
-                     stage_get_solid_data(s, b->target.x, b->target.y) != 3) ) {
+                     stage_test_plane(s, PlaneBlocking, 
+                        b->target.x, b->target.y)) ) {
                     
                     pl->target = pl->pos;
                     pl->moveTimer = 0;
@@ -69,7 +71,7 @@ static void boulder_move(Boulder* b, Player* pl, Stage* s, int16 steps) {
                     stage_update_solid(s, b->pos.x, b->pos.y, 0);
 
                     // Play sound
-                    audio_play(S_MOVE);
+                    stage_play_sound(s, S_MOVE);
                 }
             }
         }
@@ -97,20 +99,23 @@ static void boulder_update_bomb(Boulder* b, Player* pl,
     if(b->type == 1 && pl->moving && !b->oldPlayerMoveState) {
 
         b->redraw = true;
+        stage_track_boulder(s, b);
         -- b->bombTimer;
+        stage_track_boulder(s, b);
 
         // Play sound
-        audio_play(S_BEEP5);
+        stage_play_sound(s, S_BEEP5);
     }
     // Detonate
     if(b->bombTimer <= 0 && !pl->moving) {
 
+        stage_track_boulder(s, b);
         b->exist = false;
         // Detonate
         stage_detonate(s, b->pos.x, b->pos.y);
 
         // Play sound
-        audio_play(S_EXPLOSION);
+        stage_play_sound(s, S_EXPLOSION);
 
         return;
     }
@@ -126,20 +131,22 @@ static void boulder_check_collision(Boulder* b, Player* pl,
     // Only move if the player is moving
     if(!pl->moving && b->moving) {
 
+        stage_track_boulder(s, b);
         b->moving = false;
         b->pos = b->target;
         b->moveTimer = 0;
+        s->activeDirty = true;
 
         // Check if in lava
         if(b->type != 2 && 
-           stage_get_solid_data(s, b->pos.x, b->pos.y) == 3) {
+           stage_test_plane(s, PlaneLava, b->pos.x, b->pos.y)) {
 
             // Remove lava
             stage_update_tile(s, b->pos.x, b->pos.y, 0);
             stage_update_solid(s, b->pos.x, b->pos.y, 0);
 
             // Play sound
-            audio_play(S_DISAPPEAR);
+            stage_play_sound(s, S_DISAPPEAR);
 
             // Stop existing
             b->exist = false;
@@ -151,12 +158,13 @@ static void boulder_check_collision(Boulder* b, Player* pl,
             // to prevent animation. Too lazy to add
             // a different function for this...)
             s->animTimer = 0;
-            s->data[b->pos.y * s->width + b->pos.x] = 0;
-            s->solid[b->pos.y * s->width + b->pos.x] = 0;
+            stage_write_tile(s, b->pos.x, b->pos.y, 0);
+            stage_update_solid(s, b->pos.x, b->pos.y, 0);
         }
 
         // Update solid data
         stage_update_solid(s, b->pos.x, b->pos.y, 2);
+        stage_track_boulder(s, b);
     }
 }
 
@@ -271,6 +279,7 @@ void boulder_check_detonation(Boulder* b, void* _s, uint8 dx, uint8 dy) {
     if(b->pos.x >= dx-1 && b->pos.x <= dx+1 &&
        b->pos.y >= dy-1 && b->pos.y <= dy+1) {
 
+        stage_track_boulder(s, b);
         b->exist = false;
         stage_update_solid(s, b->pos.x, b->pos.y, 0);
     }
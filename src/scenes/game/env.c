@@ -0,0 +1,174 @@
+// Batched stage environments, for
+// stepping many stages at once without
+// the game loop
+// (c) 2019 Jani Nykänen
+
+#include "env.h"
+
+#include "../../core/err.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Steps used to start a move. The objects must see
+// the player moving, so the move is started with a
+// normal, small update, and the instant mode resolves
+// the rest of the turn
+static const int16 ENV_START_STEPS = 1;
+
+
+// Create an environment batch
+EnvBatch* create_env_batch(const char* mapPath, 
+    uint16 count, uint16 maxTurns) {
+
+    uint16 i;
+
+    // Allocate memory
+    EnvBatch* e = (EnvBatch*)malloc(sizeof(EnvBatch));
+    if(e == NULL) {
+
+        THROW_MALLOC_ERR;
+        return NULL;
+    }
+    e->stages = (Stage**)calloc(count, sizeof(Stage*));
+    e->turns = (uint16*)calloc(count, sizeof(uint16));
+    e->gems = (uint8*)calloc(count, sizeof(uint8));
+    e->finished = (boolean*)calloc(count, sizeof(boolean));
+    if(e->stages == NULL || e->turns == NULL || 
+       e->gems == NULL || e->finished == NULL) {
+
+        THROW_MALLOC_ERR;
+        destroy_env_batch(e);
+        return NULL;
+    }
+    e->count = count;
+    e->maxTurns = maxTurns;
+
+    // Create stages
+    for(i = 0; i < count; ++ i) {
+
+        e->stages[i] = create_stage();
+        if(e->stages[i] == NULL || 
+           stage_init(e->stages[i], mapPath) == 1) {
+
+            destroy_env_batch(e);
+            return NULL;
+        }
+        e->stages[i]->headless = true;
+        e->stages[i]->instant = true;
+    }
+
+    return e;
+}
+
+
+// Destroy
+void destroy_env_batch(EnvBatch* e) {
+
+    uint16 i;
+
+    if(e == NULL) return;
+
+    if(e->stages != NULL) {
+
+        for(i = 0; i < e->count; ++ i) {
+
+            destroy_stage(e->stages[i]);
+        }
+        free(e->stages);
+    }
+    if(e->turns != NULL) free(e->turns);
+    if(e->gems != NULL) free(e->gems);
+    if(e->finished != NULL) free(e->finished);
+    free(e);
+}
+
+
+// Reset an environment
+void env_reset(EnvBatch* e, uint16 i) {
+
+    stage_reset(e->stages[i]);
+
+    e->turns[i] = 0;
+    e->gems[i] = 0;
+    e->finished[i] = false;
+}
+
+
+// Write the observation of an environment
+void env_observe(EnvBatch* e, uint16 i, uint8* obs) {
+
+    Stage* s = e->stages[i];
+    Boulder* b;
+    uint8* timers = obs + ENV_OBS_BOMB_TIMERS*ENV_OBS_PLANE_SIZE;
+    uint8 j;
+
+    // The stage keeps the planes up to date
+    memcpy(obs, stage_get_observation(s), 
+        OBS_PLANE_COUNT*ENV_OBS_PLANE_SIZE);
+
+    // Bomb timers
+    memset(timers, 0, ENV_OBS_PLANE_SIZE);
+    for(j = 0; j < s->bcount; ++ j) {
+
+        b = &s->boulders[j];
+        if(!b->exist || b->type != 1) continue;
+
+        timers[b->pos.y*ENV_OBS_WIDTH + b->pos.x] = (uint8)b->bombTimer;
+    }
+}
+
+
+// Step a range of environments
+void env_step_range(EnvBatch* e, uint16 first, uint16 last,
+    const uint8* actions, uint8* obs, int8* rewards, boolean* done) {
+
+    uint16 i;
+    Stage* s;
+    int8 reward;
+
+    for(i = first; i < last && i < e->count; ++ i) {
+
+        s = e->stages[i];
+        if(e->finished[i]) {
+
+            env_reset(e, i);
+        }
+
+        // Move, and resolve the turn
+        if(actions[i] != ActionNone) {
+
+            pl_queue_move(&s->pl, actions[i]-1);
+        }
+        stage_update(s, ENV_START_STEPS);
+        ++ e->turns[i];
+
+        // Reward collected gems
+        reward = (int8)(s->pl.gems - e->gems[i]) * ENV_REWARD_GEM;
+        e->gems[i] = s->pl.gems;
+
+        // Check if clear
+        if(s->pl.victory ||
+           (s->pl.maxGems > 0 && s->pl.gems == s->pl.maxGems)) {
+
+            reward += ENV_REWARD_CLEAR;
+            e->finished[i] = true;
+        }
+        else if(e->maxTurns > 0 && e->turns[i] >= e->maxTurns) {
+
+            e->finished[i] = true;
+        }
+
+        rewards[i] = reward;
+        done[i] = e->finished[i];
+        env_observe(e, i, obs + (uint32)i*ENV_OBS_SIZE);
+    }
+}
+
+
+// Step all the environments
+void env_step(EnvBatch* e, 
+    const uint8* actions, uint8* obs, int8* rewards, boolean* done) {
+
+    env_step_range(e, 0, e->count, actions, obs, rewards, done);
+}
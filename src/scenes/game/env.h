@@ -0,0 +1,74 @@
+// Batched stage environments, for
+// stepping many stages at once without
+// the game loop
+// (c) 2019 Jani Nykänen
+
+#ifndef __ENV__
+#define __ENV__
+
+#include "stage.h"
+
+// Observation size per environment: the stage
+// observation planes, plus the bomb timers
+#define ENV_OBS_WIDTH STAGE_MAX_WIDTH
+#define ENV_OBS_HEIGHT STAGE_MAX_HEIGHT
+#define ENV_OBS_PLANE_SIZE (ENV_OBS_WIDTH*ENV_OBS_HEIGHT)
+#define ENV_OBS_BOMB_TIMERS OBS_PLANE_COUNT
+#define ENV_OBS_SIZE ((OBS_PLANE_COUNT+1)*ENV_OBS_PLANE_SIZE)
+
+// Actions
+enum {
+
+    ActionNone = 0,
+    ActionRight = 1,
+    ActionUp = 2,
+    ActionLeft = 3,
+    ActionDown = 4,
+};
+
+// Rewards
+#define ENV_REWARD_GEM 1
+#define ENV_REWARD_CLEAR 10
+
+// Environment batch type. Per-environment
+// data is kept in arrays
+typedef struct {
+
+    uint16 count;
+    uint16 maxTurns;
+
+    Stage** stages;
+    uint16* turns;
+    uint8* gems;
+    boolean* finished;
+
+} EnvBatch;
+
+// Create an environment batch, all
+// environments playing the same stage
+EnvBatch* create_env_batch(const char* mapPath, 
+    uint16 count, uint16 maxTurns);
+
+// Destroy
+void destroy_env_batch(EnvBatch* e);
+
+// Reset an environment
+void env_reset(EnvBatch* e, uint16 i);
+
+// Write the observation of an environment
+void env_observe(EnvBatch* e, uint16 i, uint8* obs);
+
+// Step the environments from first to last-1. The
+// buffers are indexed by the environment index
+// (obs has ENV_OBS_SIZE bytes per environment).
+// Ranges that do not overlap can be stepped in
+// parallel. Finished environments are reset on
+// the next step
+void env_step_range(EnvBatch* e, uint16 first, uint16 last,
+    const uint8* actions, uint8* obs, int8* rewards, boolean* done);
+
+// Step all the environments
+void env_step(EnvBatch* e, 
+    const uint8* actions, uint8* obs, int8* rewards, boolean* done);
+
+#endif // __ENV__
@@ -8,6 +8,7 @@
 #include <stdio.h>
 
 #include "../../core/graphics.h"
+#include "../../core/panel.h"
 #include "../../core/input.h"
 #include "../../core/application.h"
 #include "../../core/assets.h"
@@ -46,6 +47,46 @@ static int16 clearTimer;
 // Stage index
 static uint8 stageIndex;
 
+// HUD widget values
+enum {
+
+    HudStage = 0,
+    HudPickaxe = 1,
+    HudShovel = 2,
+    HudKeys = 3,
+    HudBombs = 4,
+    HudGems = 5,
+    HudMaxGems = 6,
+};
+#define HUD_VALUE_COUNT 7
+#define HUD_INVALID -1
+
+// The values the HUD widgets were last drawn with
+static int16 hudValues[HUD_VALUE_COUNT];
+
+
+// Invalidate the HUD widgets
+static void game_invalidate_hud() {
+
+    uint8 i;
+    for(i = 0; i < HUD_VALUE_COUNT; ++ i) {
+
+        hudValues[i] = HUD_INVALID;
+    }
+}
+
+
+// Check if a HUD widget needs to be redrawn
+// and store the new value
+static boolean hud_changed(uint8 widget, int16 value) {
+
+    if(hudValues[widget] == value) 
+        return false;
+
+    hudValues[widget] = value;
+    return true;
+}
+
 
 // Draw an energy bar
 static void draw_energy_bar(int x, int y, uint8 max, uint8 val) {
@@ -74,9 +115,7 @@ static void game_draw_stage_clear() {
     int16 dy = stage->topLeft.y + stage->height*8;
 
     // Draw box
-    fill_rect(dx-WIDTH/2-2, dy-HEIGHT/2-2, WIDTH+4, HEIGHT+4, 146);
-    fill_rect(dx-WIDTH/2-1, dy-HEIGHT/2-1, WIDTH+2, HEIGHT+2, 255);
-    fill_rect(dx-WIDTH/2, dy-HEIGHT/2, WIDTH, HEIGHT, 0);
+    panel_draw_box(dx-WIDTH/2, dy-HEIGHT/2, WIDTH, HEIGHT);
 
     // Draw text
     draw_text_fast(bmpFont, "STAGE CLEAR", dx, dy-4, 0, 0, true);
@@ -99,13 +138,13 @@ static void cb_change() {
 // Menu callbacks
 static void cb_resume() {
 
-    pauseMenu.active = false;
-    stage_redraw(stage);
+    if(!menu_deactivate(&pauseMenu))
+        stage_redraw(stage);
 }
 static void cb_reset() {
 
-    pauseMenu.active = false;
-    stage_redraw(stage);
+    if(!menu_deactivate(&pauseMenu))
+        stage_redraw(stage);
     tr_activate(FadeIn, 2, cb_reset_stage);
     
 }
@@ -124,9 +163,23 @@ static void cb_audio() {
     }
     pauseMenu.redraw = true;
 }
+static void cb_anim() {
+
+    // Toggle the instant mode & change the text
+    stage_set_instant(stage, !stage->instant);
+    if(!stage->instant) {
+        pauseMenu.text[3] [8] = 'N';
+        pauseMenu.text[3] [9] = ' ';
+    }
+    else {
+        pauseMenu.text[3] [8] = 'F';
+        pauseMenu.text[3] [9] = 'F';
+    }
+    pauseMenu.redraw = true;
+}
 static void cb_quit() {
-    pauseMenu.active = false;
-    stage_redraw(stage);
+    if(!menu_deactivate(&pauseMenu))
+        stage_redraw(stage);
     tr_activate(FadeIn, 2, cb_change);
 }
 // Create pause menu
@@ -139,6 +192,7 @@ static void game_create_pause_menu() {
     menu_add_button(&pauseMenu, "RESUME", cb_resume);
     menu_add_button(&pauseMenu, "RESTART", cb_reset);
     menu_add_button(&pauseMenu, "AUDIO: ON ", cb_audio);
+    menu_add_button(&pauseMenu, "ANIM: ON ", cb_anim);
     menu_add_button(&pauseMenu, "QUIT", cb_quit);
 }
 
@@ -155,6 +209,7 @@ static int16 game_init() {
 
     // Set defaults
     redrawHUD = true;
+    game_invalidate_hud();
     clearTimer = 0;
     stageClear = false;
     redrawClear = false;
@@ -224,6 +279,11 @@ static void game_update(int16 steps) {
 
     // Update stage
     stage_update(stage, steps);
+    if(stage->infoChanged) {
+
+        redrawHUD = true;
+        stage->infoChanged = false;
+    }
 
     // Check if the stage is clear
     if(stage->pl.maxGems > 0 && stage->pl.gems == stage->pl.maxGems) {
@@ -250,6 +310,14 @@ static void game_draw() {
     // Draw stage clear
     if(stageClear) {
 
+        // The last gem pickup
+        if(redrawHUD) {
+
+            game_redraw_info(&stage->pl);
+            redrawHUD = false;
+        }
+
+
         if(redrawClear) {
 
             game_draw_stage_clear();
@@ -301,8 +369,10 @@ static void game_on_change(void* param) {
         app_terminate();
     }
 
-    // Set re-render flags
+    // Set re-render flags (the frame is
+    // redrawn, so are the HUD widgets)
     redrawHUD = true;
+    game_invalidate_hud();
     redrawClear = false;
     stageClear = false;
 
@@ -329,7 +399,8 @@ Scene game_get_scene() {
 }
 
 
-// Draw info
+// Draw info. Only the widgets whose values
+// have changed are redrawn
 void game_redraw_info(Player* pl) {
 
     const int TOP_X = 24*8+24;
@@ -344,47 +415,100 @@ void game_redraw_info(Player* pl) {
     const int BAR_MAX = 5;
 
     uint8 i = 0;
+    uint8 start, end;
+    boolean full;
     char buf[10];
 
     // Draw stage name
-    snprintf(buf, 10, "STAGE %d", (int16)stageIndex);
-    draw_text_fast(bmpFont, buf, 
-        TOP_X + FRAME_WIDTH/2, TOP_Y+8,0,0, true);
-
-    // Draw consumable item icons
-    draw_bitmap_region_fast(bmpItems, 16, 0, 16, 16,
-        TOP_X+ITEM_X, TOP_Y+ITEM_START_Y);
-    draw_bitmap_region_fast(bmpItems, 32, 0, 16, 16,
-        TOP_X+ITEM_X, TOP_Y+ITEM_START_Y+ITEM_OFF_Y);
-
-    // Draw corresponding energy bars
-    draw_energy_bar(TOP_X+ITEM_X+ITEM_OFF_X, 
-        TOP_Y+ITEM_START_Y+1, 
-        BAR_MAX, pl->pickaxe);
-    draw_energy_bar(TOP_X+ITEM_X+ITEM_OFF_X, 
-        TOP_Y+ITEM_START_Y+ITEM_OFF_Y+1, 
-        BAR_MAX, pl->shovel);
-
-    // Draw collectable item icons
-    draw_bitmap_region_fast(bmpItems, 0, 0, 16, 16,
-        TOP_X+ITEM_X, TOP_Y+ITEM_START_Y+ITEM_OFF_Y*2);
-    draw_bitmap_region_fast(bmpItems, 48, 0, 16, 16,
-        TOP_X+ITEM_X, TOP_Y+ITEM_START_Y+ITEM_OFF_Y*3);
-
-    // Draw collectable item counts
-    snprintf(buf, 10, "\2%d", (int16)pl->keys);
-    draw_text_fast(bmpFont, buf, 
-        TOP_X+ITEM_X+ITEM_OFF_X, 
-        TOP_Y+ITEM_START_Y+ITEM_OFF_Y*2 +4, 
-        0, 0, false);
-    snprintf(buf, 10, "\2%d", (int16)pl->bombs);
-    draw_text_fast(bmpFont, buf, 
-        TOP_X+ITEM_X+ITEM_OFF_X, 
-        TOP_Y+ITEM_START_Y+ITEM_OFF_Y*3 +4, 
-        0, 0, false);
-
-    // Draw gems
-    for(i = 0; i < pl->maxGems; ++ i) {
+    if(hud_changed(HudStage, stageIndex)) {
+
+        snprintf(buf, 10, "STAGE %d", (int16)stageIndex);
+        draw_text_fast(bmpFont, buf, 
+            TOP_X + FRAME_WIDTH/2, TOP_Y+8,0,0, true);
+    }
+
+    // Draw consumable item icons & the
+    // corresponding energy bars
+    full = hudValues[HudPickaxe] == HUD_INVALID;
+    if(hud_changed(HudPickaxe, pl->pickaxe)) {
+
+        if(full) {
+
+            draw_bitmap_region_fast(bmpItems, 16, 0, 16, 16,
+                TOP_X+ITEM_X, TOP_Y+ITEM_START_Y);
+        }
+        draw_energy_bar(TOP_X+ITEM_X+ITEM_OFF_X, 
+            TOP_Y+ITEM_START_Y+1, 
+            BAR_MAX, pl->pickaxe);
+    }
+    full = hudValues[HudShovel] == HUD_INVALID;
+    if(hud_changed(HudShovel, pl->shovel)) {
+
+        if(full) {
+
+            draw_bitmap_region_fast(bmpItems, 32, 0, 16, 16,
+                TOP_X+ITEM_X, TOP_Y+ITEM_START_Y+ITEM_OFF_Y);
+        }
+        draw_energy_bar(TOP_X+ITEM_X+ITEM_OFF_X, 
+            TOP_Y+ITEM_START_Y+ITEM_OFF_Y+1, 
+            BAR_MAX, pl->shovel);
+    }
+
+    // Draw collectable item icons & counts
+    full = hudValues[HudKeys] == HUD_INVALID;
+    if(hud_changed(HudKeys, pl->keys)) {
+
+        if(full) {
+
+            draw_bitmap_region_fast(bmpItems, 0, 0, 16, 16,
+                TOP_X+ITEM_X, TOP_Y+ITEM_START_Y+ITEM_OFF_Y*2);
+        }
+        snprintf(buf, 10, "\2%d", (int16)pl->keys);
+        draw_text_fast(bmpFont, buf, 
+            TOP_X+ITEM_X+ITEM_OFF_X, 
+            TOP_Y+ITEM_START_Y+ITEM_OFF_Y*2 +4, 
+            0, 0, false);
+    }
+    full = hudValues[HudBombs] == HUD_INVALID;
+    if(hud_changed(HudBombs, pl->bombs)) {
+
+        if(full) {
+
+            draw_bitmap_region_fast(bmpItems, 48, 0, 16, 16,
+                TOP_X+ITEM_X, TOP_Y+ITEM_START_Y+ITEM_OFF_Y*3);
+        }
+        snprintf(buf, 10, "\2%d", (int16)pl->bombs);
+        draw_text_fast(bmpFont, buf, 
+            TOP_X+ITEM_X+ITEM_OFF_X, 
+            TOP_Y+ITEM_START_Y+ITEM_OFF_Y*3 +4, 
+            0, 0, false);
+    }
+
+    // Draw gems. If only the gem count has changed,
+    // redraw the icons between the old and the new count
+    if(hud_changed(HudMaxGems, pl->maxGems)) {
+
+        start = 0;
+        end = pl->maxGems;
+        hudValues[HudGems] = pl->gems;
+    }
+    else if(hudValues[HudGems] != pl->gems) {
+
+        start = (uint8)hudValues[HudGems];
+        end = pl->gems;
+        if(start > end) {
+
+            start = pl->gems;
+            end = (uint8)hudValues[HudGems];
+        }
+        hudValues[HudGems] = pl->gems;
+    }
+    else {
+
+        return;
+    }
+
+    for(i = start; i < end; ++ i) {
 
         draw_bitmap_region_fast(bmpItems, 
             i < pl->gems ? 64 : 80, 0, 16, 16,
@@ -401,6 +525,7 @@ void game_clear_assets() {
     if(assetsLoaded) {
 
         ass_remove("frame");
+        panel_clear_cache();
         ass_remove("tileset");
         ass_remove("anim");
         ass_remove("items");
@@ -425,9 +550,9 @@ int16 game_load_assets() {
         if(
             BITMAP("ASSETS/BITMAPS/FRAME.BIN", "frame") ||
             BITMAP("ASSETS/BITMAPS/TILESET.BIN", "tileset") ||
-            BITMAP("ASSETS/BITMAPS/ANIM.BIN", "anim") ||
+            BITMAP_MIRRORED("ASSETS/BITMAPS/ANIM.BIN", "anim") ||
             BITMAP("ASSETS/BITMAPS/ITEMS.BIN", "items") ||
-            BITMAP("ASSETS/BITMAPS/PLAYER.BIN", "player") ||
+            BITMAP_MIRRORED("ASSETS/BITMAPS/PLAYER.BIN", "player") ||
             BITMAP("ASSETS/BITMAPS/EXP.BIN", "exp") ||
             BITMAP("ASSETS/BITMAPS/SHIP.BIN", "ship")) {
 
@@ -25,8 +25,7 @@ static Bitmap* bmpPlayer;
 // Check if free tile
 static bool pl_check_free_tile(Player* pl, Stage* s, uint8 tx, uint8 ty) {
 
-    uint8 t = stage_get_solid_data(s, tx, ty);
-    return t == 0 || t == 2 || t == 8;
+    return stage_test_plane(s, PlaneWalkable, tx, ty);
 }
 
 
@@ -42,36 +41,90 @@ static int16 get_down_state(int16 arrow) {
 }
 
 
+// Queue moves pressed during a move
+static void pl_queue_moves(Player* pl, Stage* s) {
+
+    // Same order as in pl_control
+    static const uint8 ARROWS[] = {
+        ArrowLeft, ArrowRight, ArrowUp, ArrowDown
+    };
+    uint8 i;
+
+    // Headless stages are only controlled
+    // through the queue
+    if(s->headless) return;
+
+    for(i = 0; i < 4; ++ i) {
+
+        if(pl->queueLength < MOVE_QUEUE_SIZE &&
+           input_get_arrow_key(ARROWS[i]) == StatePressed) {
+
+            pl->moveQueue[pl->queueLength ++] = ARROWS[i];
+        }
+    }
+}
+
+
 // Control player
 static void pl_control(Player* pl, Stage* s) {
 
     uint8 tx = pl->pos.x;
     uint8 ty = pl->pos.y;
     uint8 dir;
-    int16 state;
+    uint8 arrow;
+    int16 state = -1;
     boolean flip = false;
+    uint8 i;
 
-    // Check arrow keys
-    if( (state = get_down_state(ArrowLeft)) >= 0) {
+    // Take a queued move first, it counts as a press
+    if(pl->queueLength > 0) {
 
-        -- tx;
-        dir = 3;
-        flip = true;
-    }
-    else if( (state = get_down_state(ArrowRight)) >= 0) {
+        arrow = pl->moveQueue[0];
+        for(i = 1; i < pl->queueLength; ++ i) {
 
-        ++ tx;
-        dir = 2;
-    }
-    else if( (state = get_down_state(ArrowUp)) >= 0) {
-
-        -- ty;
-        dir = 1;
+            pl->moveQueue[i-1] = pl->moveQueue[i];
+        }
+        -- pl->queueLength;
+        state = 1;
     }
-    else if( (state = get_down_state(ArrowDown)) >= 0) {
-
-        ++ ty;
-        dir = 0;
+    // Check arrow keys (headless stages are only
+    // controlled through the queue)
+    else if(s->headless)
+        state = -1;
+    else if( (state = get_down_state(ArrowLeft)) >= 0)
+        arrow = ArrowLeft;
+    else if( (state = get_down_state(ArrowRight)) >= 0)
+        arrow = ArrowRight;
+    else if( (state = get_down_state(ArrowUp)) >= 0)
+        arrow = ArrowUp;
+    else if( (state = get_down_state(ArrowDown)) >= 0)
+        arrow = ArrowDown;
+
+    if(state >= 0) {
+
+        switch (arrow)
+        {
+        case ArrowLeft:
+            -- tx;
+            dir = 3;
+            flip = true;
+            break;
+
+        case ArrowRight:
+            ++ tx;
+            dir = 2;
+            break;
+
+        case ArrowUp:
+            -- ty;
+            dir = 1;
+            break;
+
+        default:
+            ++ ty;
+            dir = 0;
+            break;
+        }
     }
 
     if(pl->forceRelease) {
@@ -93,9 +146,8 @@ static void pl_control(Player* pl, Stage* s) {
         pl->flip = flip;
         pl->redraw = true;
 
-        // Check if free
-        if( (tx > 0 && ty > 0 && tx < s->width-1 && ty < s->height-1) &&
-            pl_check_free_tile(pl, s, tx, ty) ) {
+        // Check if free (the stage borders are never free)
+        if(pl_check_free_tile(pl, s, tx, ty)) {
 
             // Start moving
             pl->moveTimer = MOVE_TIME;
@@ -107,17 +159,20 @@ static void pl_control(Player* pl, Stage* s) {
         // Otherwise activate possibly solid tile
         else if(state == 1) {
 
+            stage_track_player(s, pl);
             if(stage_activate_tile(pl, tx, ty, s)) {
 
                 pl->acting = true;
                 pl->direction = dir;
                 pl->flip = flip;
             }
+            stage_track_player(s, pl);
         }
 
         // Special check, if a bombing place
-        if(stage_get_solid_data(s, tx, ty) == 8) {
+        if(STAGE_SOLID(s, tx, ty) == 8) {
 
+            stage_track_player(s, pl);
             if(stage_activate_tile(pl, tx, ty, s)) {
 
                 pl->moving = false;
@@ -126,6 +181,7 @@ static void pl_control(Player* pl, Stage* s) {
 
                 pl->forceRelease = true;
             }
+            stage_track_player(s, pl);
         }
     }
 }
@@ -189,6 +245,7 @@ Player create_player(uint8 x, uint8 y) {
     pl.acting = false;
     pl.forceRelease = false;
     pl.victory = false;
+    pl.queueLength = 0;
 
     return pl;
 }
@@ -199,10 +256,15 @@ void pl_update(Player* pl, void* _s, int steps) {
 
     Stage* s = (Stage*)_s;
 
-    // Check input
-    if(pl->moveTimer <= 0) {
+    // Check input, or queue the moves pressed
+    // while moving (no input when the stage is
+    // settling an instant turn)
+    if(!s->settling) {
 
-        pl_control(pl, s);
+        if(pl->moveTimer <= 0)
+            pl_control(pl, s);
+        else
+            pl_queue_moves(pl, s);
     }
 
     // Animate
@@ -218,16 +280,29 @@ void pl_update(Player* pl, void* _s, int steps) {
 
             pl->moveTimer = 0;
             // Move to the target
+            stage_track_player(s, pl);
             pl->pos = pl->target;
             pl->moving = false;
 
             // Check item collisions
             stage_item_collision(pl, s);
+            stage_track_player(s, pl);
         }
     }
 }
 
 
+// Queue a move
+boolean pl_queue_move(Player* pl, uint8 arrow) {
+
+    if(pl->queueLength >= MOVE_QUEUE_SIZE)
+        return false;
+
+    pl->moveQueue[pl->queueLength ++] = arrow;
+    return true;
+}
+
+
 // Draw player
 void pl_draw(Player* pl, void* _s,  int dx, int dy) {
 
@@ -7,6 +7,9 @@
 #include "../../core/types.h"
 #include "../../core/sprite.h"
 
+// Moves that can be queued during a move
+#define MOVE_QUEUE_SIZE 1
+
 
 // Player type
 typedef struct
@@ -26,6 +29,10 @@ typedef struct
     boolean forceRelease;
     boolean victory;
 
+    // Queued moves (arrow keys pressed during a move)
+    uint8 moveQueue [MOVE_QUEUE_SIZE];
+    uint8 queueLength;
+
     // Item info
     uint8 pickaxe;
     uint8 shovel;
@@ -45,6 +52,10 @@ Player create_player(uint8 x, uint8 y);
 // Update player
 void pl_update(Player* pl, void* s, int steps);
 
+// Queue a move (as if the arrow key was pressed).
+// Returns false if the queue is full
+boolean pl_queue_move(Player* pl, uint8 arrow);
+
 // Draw player
 void pl_draw(Player* pl, void* s, int dx, int dy);
 
@@ -8,86 +8,296 @@
 #include "../../core/assets.h"
 #include "../../core/mathext.h"
 #include "../../core/audio.h"
+#include "../../core/input.h"
+#include "../../core/panel.h"
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
-#include "game.h"
+#include "stagepool.h"
 
 // Initial animation time
 static const int8 INITIAL_ANIM_TIME = 32;
 static const int8 ANIM_SKIP = 8;
 
+// Instant mode: steps per settling update & 
+// the maximum amount of settling updates
+static const int16 INSTANT_STEPS = 32;
+static const int16 INSTANT_MAX_UPDATES = 16;
+// The most times a bomb can be pushed before it
+// goes off (the bomb timer)
+#define BOMB_PUSH_MAX 5
+
+// Bit-planes for each solid value
+#define PLANE_BIT(p) (1 << (p))
+static const uint8 SOLID_PLANES[] = {
+
+    // Free
+    PLANE_BIT(PlaneWalkable),
+    // Wall
+    PLANE_BIT(PlaneBlocking),
+    // Boulder
+    PLANE_BIT(PlaneBlocking) | PLANE_BIT(PlanePushable) | 
+        PLANE_BIT(PlaneWalkable),
+    // Lava
+    PLANE_BIT(PlaneLava) | PLANE_BIT(PlaneActivatable),
+    // Switch
+    PLANE_BIT(PlaneBlocking) | PLANE_BIT(PlaneActivatable),
+    // Frozen wall
+    PLANE_BIT(PlaneBlocking) | PLANE_BIT(PlaneActivatable),
+    // Lock
+    PLANE_BIT(PlaneBlocking) | PLANE_BIT(PlaneActivatable),
+    // Frozen boulder
+    PLANE_BIT(PlaneBlocking) | PLANE_BIT(PlaneActivatable),
+    // Bomb place
+    PLANE_BIT(PlaneBlocking) | PLANE_BIT(PlaneActivatable) | 
+        PLANE_BIT(PlaneWalkable),
+};
 
-// Draw frame
-static void draw_box_frame(Bitmap* bmp, 
-    int dx, int dy, int w, int h, uint8 c) {
 
-    const int TILE_W = 8;
-    const int TILE_H = 8;
+// Get a hash key. Keys are computed instead
+// of stored in tables to save memory
+static uint64 hash_key(uint8 kind, uint8 index, uint8 value) {
 
-    int x = 0;
-    int y = 0;
-    int sx = 0;
-    int sy = 0;
+    uint64 z = ((uint64)kind << 16 | (uint16)index << 8 | value) 
+        + 0x9E3779B97F4A7C15ULL;
 
-    for(; y < h; ++ y) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
 
-        for(x = 0; x < w; ++ x) {
+    return z ^ (z >> 31);
+}
 
-            // Skip, if empty
-            if(x == 0+1 && y > 0 && y < 0+h-1)
-                x += w-2;
 
-            // Determine tile source position
-            if(x == 0 && y == 0) {
+// Get the hash key of a boulder
+static uint64 get_boulder_key(Stage* s, Boulder* b) {
 
-                sx = 0; sy = 0;
-            }
-            else if(x == w-1 && y == 0) {
+    return hash_key(HashBoulder, 
+        STAGE_INDEX(s, b->pos.x, b->pos.y), 
+        b->type << 4 | (uint8)(b->bombTimer & 0x0F));
+}
 
-                sx = 16; sy = 0;
-            }
-            else if(x == w-1 && y == h-1) {
 
-                sx = 16; sy = 16;
-            }
-            else if(x == 0 && y == h-1) {
+// Get the hash key of the player, items included
+static uint64 get_player_key(Stage* s, Player* pl) {
 
-                sx = 0; sy = 16;
-            }
-            else if(y == 0) {
+    return hash_key(HashPlayer, 
+            STAGE_INDEX(s, pl->pos.x, pl->pos.y), 0) ^
+        hash_key(HashItem, 0, pl->pickaxe) ^
+        hash_key(HashItem, 1, pl->shovel) ^
+        hash_key(HashItem, 2, pl->bombs) ^
+        hash_key(HashItem, 3, pl->keys) ^
+        hash_key(HashItem, 4, pl->gems);
+}
 
-                sx = 8; sy = 0;
-            }
-            else if(y == h-1) {
 
-                sx = 8; sy = 16;
-            }
-            else if(x == 0) {
+// Make a private copy of shared tile data
+static boolean stage_own_tiles(Stage* s) {
 
-                sx = 0; sy = 8;
-            }
-            else if(x == w-1) {
+    uint16 size = sizeof(Tile) * s->stride*(s->height+2);
+    Tile* tiles;
 
-                sx = 16; sy = 8;
-            }
+    if(s->ownsTiles) return true;
 
-            // Draw tile
-            draw_bitmap_region_fast(bmp, sx, sy, 
-                TILE_W, TILE_H, dx+x*TILE_W, dy+y*TILE_H);
-        }
+    tiles = (Tile*)stage_pool_alloc(s->pool, size);
+    if(tiles == NULL) {
+
+        err_throw_no_param("Stage pool is full.");
+        s->forkFailed = true;
+        return false;
+    }
+    memcpy(tiles, s->tiles, size);
+
+    s->tiles = tiles;
+    s->ownsTiles = true;
+
+    return true;
+}
+
+
+// Make a private copy of shared boulders
+static boolean stage_own_boulders(Stage* s) {
+
+    uint16 size = sizeof(Boulder) * s->bcount;
+    Boulder* boulders;
+
+    if(s->ownsBoulders) return true;
+
+    boulders = (Boulder*)stage_pool_alloc(s->pool, size);
+    if(boulders == NULL) {
+
+        err_throw_no_param("Stage pool is full.");
+        s->forkFailed = true;
+        return false;
+    }
+    memcpy(boulders, s->boulders, size);
+
+    s->boulders = boulders;
+    s->ownsBoulders = true;
+
+    return true;
+}
+
+
+// Can the player walk through a solid value
+// without pushing or activating anything
+#define SOLID_PASSABLE(v) \
+    ((SOLID_PLANES[v] & (PLANE_BIT(PlaneWalkable) | PLANE_BIT(PlaneBlocking))) \
+        == PLANE_BIT(PlaneWalkable))
+
+
+// Write solid data & the bit-planes
+static void stage_write_solid(Stage* s, uint8 x, uint8 y, uint8 value) {
+
+    uint8 i;
+    uint8 bits = SOLID_PLANES[value];
+    uint8 row = (uint8)(y+1);
+    uint16 mask = 1 << (uint8)(x+1);
+    uint8 index = STAGE_INDEX(s, x, y);
+    uint8 old;
+    uint16 near;
+
+    if(!stage_own_tiles(s)) return;
+    old = s->tiles[index].solid;
+
+    // Nothing can be moved to the outermost tiles
+    if(x == 0 || y == 0 || x == s->width-1 || y == s->height-1) {
+
+        bits = (bits & ~PLANE_BIT(PlaneWalkable)) | PLANE_BIT(PlaneBlocking);
+    }
+
+    // Update hash
+    if(old != value) {
+
+        s->hash ^= hash_key(HashSolid, index, old) ^ 
+            hash_key(HashSolid, index, value);
+    }
+
+    // Invalidate the reachable region, if the tile is in 
+    // the region or on its boundary and its passability
+    // changes
+    if(s->reachValid && row > 0 && row <= s->height &&
+       SOLID_PASSABLE(old) != SOLID_PASSABLE(value)) {
+
+        near = s->reach[row] | s->reach[row] << 1 | s->reach[row] >> 1 |
+            s->reach[row-1] | s->reach[row+1];
+        if(near & mask)
+            s->reachValid = false;
+    }
+
+    s->tiles[index].solid = value;
+    for(i = 0; i < PLANE_COUNT; ++ i) {
+
+        if(bits & PLANE_BIT(i))
+            s->planes[i][row] |= mask;
+        else
+            s->planes[i][row] &= ~mask;
+    }
+}
+
+
+// Get the observation plane of a tile
+static uint8 get_obs_plane(uint8 id) {
+
+    switch (id)
+    {
+    // Walls, solid color blocks & locks
+    case 1:
+    case 7:
+    case 8:
+    case 9:
+    case 10:
+        return ObsWalls;
+
+    // Ice
+    case 2:
+    case 3:
+        return ObsIce;
+
+    // Lava
+    case 4:
+        return ObsLava;
+
+    // Bomb places are walkable (a placed bomb 
+    // is shown in the bomb plane)
+    case 6:
+        return ObsBombPlaces;
+
+    // Items & the ship
+    case 18:
+    case 19:
+    case 20:
+    case 21:
+    case 22:
+    case 24:
+        return ObsItems;
+
+    // Switches
+    case 14:
+    case 15:
+    case 16:
+    case 30:
+    case 31:
+    case 32:
+        return ObsSwitches;
+
+    default:
+        break;
     }
 
-    // Fill with black
-    fill_rect(dx+TILE_W, dy+TILE_W,
-        (w-2)*TILE_W, (h-2)*TILE_H, c);
+    return OBS_NONE;
+}
+
+
+// Toggle an observation cell
+static void stage_toggle_obs(Stage* s, uint8 plane, uint8 x, uint8 y) {
+
+    if(plane == OBS_NONE || x >= s->width || y >= s->height) 
+        return;
 
-    // Draw shadows
-    fill_rect(dx + w*TILE_W, dy+TILE_H, 
-        TILE_W, h*TILE_H, 51);
-    fill_rect(dx + TILE_W, dy + h*TILE_H, 
-        (w-1)*TILE_W, TILE_H, 51);
+    s->obs[plane][y][x] ^= 1;
+}
+
+
+// Get the switch group of a tile
+static uint8 get_switch_group(uint8 id) {
+
+    // Color blocks
+    if(id >= 8 && id <= 13)
+        return (id-8) % 3 + 1;
+    // Switches
+    if(id >= 14 && id <= 16)
+        return id-13;
+    if(id >= 30 && id <= 32)
+        return id-29;
+
+    return 0;
+}
+
+
+// Copy tile data from the tilemap, and surround
+// it with a ring of walls
+static void stage_load_tiles(Stage* s) {
+
+    int16 x, y;
+    uint8* src = s->tmap->layers[0] + s->tmap->width;
+
+    for(y = -1; y <= s->height; ++ y) {
+
+        for(x = -1; x <= s->width; ++ x) {
+
+            // Sentinel
+            if(x < 0 || y < 0 || x == s->width || y == s->height) {
+
+                stage_write_tile(s, (uint8)x, (uint8)y, 1);
+                continue;
+            }
+
+            stage_write_tile(s, (uint8)x, (uint8)y,
+                (uint8)max_int16(src[y*s->tmap->width + x], 16) -16);
+        }
+    }
 }
 
 
@@ -128,8 +338,10 @@ static void stage_draw_animation(Stage* s, int16 topx, int16 topy) {
         dy = (int16)(s->animPos.y)-1;
         sw = dx + 2;
         sh = dy + 2;
-        if(dx < 0) dx = 0; if(sw > s->width-1) sw = s->width-1;
-        if(dy < 0) dy = 0; if(sh > s->height-1) sh = s->height-1;
+        if(dx < 0) dx = 0;
+        if(sw > s->width-1) sw = s->width-1;
+        if(dy < 0) dy = 0;
+        if(sh > s->height-1) sh = s->height-1;
         stage_draw_static(s, 
             dx, dy,
             sw, sh,
@@ -187,6 +399,28 @@ static void stage_draw_animation(Stage* s, int16 topx, int16 topy) {
     }     
 }
 
+
+// Draw tiles that have changed
+static void stage_draw_dirty(Stage* s, int16 dx, int16 dy) {
+
+    uint8 x, y;
+
+    if(!s->dirty) return;
+
+    for(y = 0; y < s->height; ++ y) {
+
+        for(x = 0; x < s->width; ++ x) {
+
+            if(STAGE_CELL(s, x, y).flags & TILE_DIRTY) {
+
+                stage_draw_static(s, x, y, x, y, dx, dy, 0);
+            }
+        }
+    }
+    s->dirty = false;
+}
+
+
 // Draw lava
 static void stage_draw_lava(Stage* s, int dx, int dy) {
 
@@ -206,7 +440,7 @@ static void stage_draw_lava(Stage* s, int dx, int dy) {
 
         for(x = 0; x < s->width; ++ x) {
 
-            if(s->data[y*s->width+x] != 4)
+            if(!(STAGE_CELL(s, x, y).flags & TILE_LAVA))
                 continue;
 
             // Check if disappearing lava
@@ -242,13 +476,267 @@ static void stage_add_boulder(Stage* s, uint8 x, uint8 y, uint8 type) {
         if(!s->boulders[i].exist) {
 
             s->boulders[i] = create_boulder(x, y, type);
-            s->solid[y*s->width+x] = 2;
+            stage_track_boulder(s, &s->boulders[i]);
+            stage_write_solid(s, x, y, 2);
+            s->activeDirty = true;
             break;
         }
     }
 }
 
 
+// Collect the boulders that need updating: moving
+// boulders, bombs, black holes and boulders near the
+// player target
+static void stage_collect_active(Stage* s) {
+
+    uint8 i;
+    Boulder* b;
+    Byte2 t = s->pl.target;
+
+    s->activeCount = 0;
+    for(i = 0; i < s->bcount; ++ i) {
+
+        b = &s->boulders[i];
+        if(!b->exist) 
+            continue;
+
+        if(b->moving || b->type != 0 ||
+           (abs_int16((int16)t.x-(int16)b->pos.x) <= 2 &&
+            abs_int16((int16)t.y-(int16)b->pos.y) <= 2) ) {
+
+            s->active[s->activeCount ++] = i;
+        }
+    }
+
+    s->activeTarget = t;
+    s->activeDirty = false;
+}
+
+
+// Test a bit in a padded bitboard
+#define BIT_AT(rows, px, py) (((rows)[py] >> (px)) & 1)
+
+
+// Mark the dead cells of wall runs: a run of free
+// cells that all have a permanent wall on the same
+// side (dx, dy), ends at permanent walls and has no
+// goals. A boulder there can never leave the run
+static void stage_mark_wall_runs(Stage* s, const uint16* perm,
+    const uint16* goal, int16 dx, int16 dy) {
+
+    // Runs go along the wall
+    int16 rx = dy != 0 ? 1 : 0;
+    int16 ry = dx != 0 ? 1 : 0;
+    int16 x, y, px, py;
+    int16 len, i;
+    boolean dead;
+
+    for(y = 1; y <= s->height; ++ y) {
+
+        for(x = 1; x <= s->width; ++ x) {
+
+            // Start a run only after a permanent wall
+            if(BIT_AT(perm, x, y) || !BIT_AT(perm, x-rx, y-ry))
+                continue;
+
+            dead = true;
+            len = 0;
+            px = x;
+            py = y;
+            while(!BIT_AT(perm, px, py)) {
+
+                if(BIT_AT(goal, px, py) || 
+                   !BIT_AT(perm, px+dx, py+dy)) {
+
+                    dead = false;
+                }
+                px += rx;
+                py += ry;
+                ++ len;
+            }
+
+            if(!dead) continue;
+            for(i = 0; i < len; ++ i) {
+
+                s->dead[y + i*ry] |= 1 << (x + i*rx);
+            }
+        }
+    }
+}
+
+
+// Find the cells where a boulder can never be
+// pushed into lava anymore
+static void stage_find_dead_cells(Stage* s) {
+
+    uint16 perm [STAGE_MAX_HEIGHT+2];
+    uint16 goal [STAGE_MAX_HEIGHT+2];
+    uint16 bomb [STAGE_MAX_HEIGHT+2];
+    uint16 blast [STAGE_MAX_HEIGHT+2];
+    // The sentinel ring & the outermost tiles
+    uint16 edge = (1 << (s->width+1)) | (1 << s->width) | 3;
+    uint16 full = 0xFFFF >> (STAGE_MAX_WIDTH - s->width);
+    // The cells a blast may destroy (not the outermost ones)
+    uint16 inner = (full >> 2) & ~3;
+    uint16 r, prev;
+    boolean blackHoles = false;
+    int16 x, y, i;
+    uint8 t;
+
+    memset(bomb, 0, sizeof(bomb));
+    memset(blast, 0, sizeof(blast));
+    memset(goal, 0, sizeof(goal));
+
+    // Bombs are placed on the bomb places
+    for(y = 0; y < s->height; ++ y) {
+
+        for(x = 0; x < s->width; ++ x) {
+
+            t = STAGE_TILE(s, x, y);
+            if(t == 23)
+                blackHoles = true;
+            else if(t == 6) 
+                bomb[y+1] |= 1 << (x+1);
+        }
+    }
+
+    // A placed bomb is pushable, once per turn until
+    // it goes off. Walls do not stop the spreading,
+    // since earlier blasts may have removed them
+    for(i = 0; i < BOMB_PUSH_MAX; ++ i) {
+
+        prev = 0;
+        for(y = 1; y <= s->height; ++ y) {
+
+            r = bomb[y];
+            bomb[y] = (r | (r << 1) | (r >> 1) | prev | bomb[y+1]) & full;
+            prev = r;
+        }
+    }
+
+    // The cells next to a detonating bomb
+    for(y = 2; y < s->height; ++ y) {
+
+        r = bomb[y-1] | bomb[y] | bomb[y+1];
+        blast[y] = (r | (r << 1) | (r >> 1)) & inner;
+    }
+
+    // Permanent walls & goals. Black holes go through
+    // anything, so then only the border (which nothing
+    // can be moved to) is permanent.
+    // Walls in a blast area become lava, and so do the
+    // open color blocks once switched solid
+    for(y = 0; y < s->height+2; ++ y) {
+
+        perm[y] = (y <= 1 || y >= s->height) ? full : edge;
+    }
+    for(y = 0; y < s->height; ++ y) {
+
+        for(x = 0; x < s->width; ++ x) {
+
+            t = STAGE_TILE(s, x, y);
+            if(t == 4) {
+
+                goal[y+1] |= 1 << (x+1);
+            }
+            else if(BIT_AT(blast, x+1, y+1)) {
+
+                if(t == 1 || (t >= 7 && t <= 13))
+                    goal[y+1] |= 1 << (x+1);
+            }
+            else if(t == 1 && !blackHoles) {
+
+                perm[y+1] |= 1 << (x+1);
+            }
+        }
+    }
+
+    // Corners
+    memset(s->dead, 0, sizeof(s->dead));
+    for(y = 1; y <= s->height; ++ y) {
+
+        s->dead[y] = ~perm[y] & ~goal[y] & full &
+            (perm[y-1] | perm[y+1]) & ((perm[y] << 1) | (perm[y] >> 1));
+    }
+
+    // Wall runs
+    stage_mark_wall_runs(s, perm, goal, 0, -1);
+    stage_mark_wall_runs(s, perm, goal, 0, 1);
+    stage_mark_wall_runs(s, perm, goal, -1, 0);
+    stage_mark_wall_runs(s, perm, goal, 1, 0);
+}
+
+
+// Flood fill the region the player can reach
+static void stage_compute_reach(Stage* s) {
+
+    uint16 passable [STAGE_MAX_HEIGHT+2];
+    uint16 r;
+    uint8 y;
+    boolean changed = true;
+
+    for(y = 0; y < s->height+2; ++ y) {
+
+        passable[y] = s->planes[PlaneWalkable][y] & 
+            ~s->planes[PlaneBlocking][y];
+        s->reach[y] = 0;
+    }
+    s->reach[s->pl.pos.y+1] = 1 << (s->pl.pos.x+1);
+
+    // Grow the region until it stops changing (the
+    // sentinel rows are never passable)
+    while(changed) {
+
+        changed = false;
+        for(y = 1; y <= s->height; ++ y) {
+
+            r = s->reach[y];
+            r |= (r << 1) | (r >> 1) | s->reach[y-1] | s->reach[y+1];
+            r &= passable[y];
+
+            if(r != s->reach[y]) {
+
+                s->reach[y] = r;
+                changed = true;
+            }
+        }
+    }
+
+    s->reachValid = true;
+}
+
+
+// Compute the state hash & the observation
+// planes from scratch
+static void stage_compute_state(Stage* s) {
+
+    uint16 i;
+    uint8 x, y;
+
+    s->reachValid = false;
+
+    memset(s->obs, 0, sizeof(s->obs));
+    for(y = 0; y < s->height; ++ y) {
+
+        for(x = 0; x < s->width; ++ x) {
+
+            stage_toggle_obs(s, get_obs_plane(STAGE_TILE(s, x, y)), x, y);
+        }
+    }
+
+    // Tracking toggles the hash as well, but it is
+    // overwritten with a from-scratch one below
+    for(i = 0; i < s->bcount; ++ i) {
+
+        stage_track_boulder(s, &s->boulders[i]);
+    }
+    stage_track_player(s, &s->pl);
+
+    s->hash = stage_compute_hash(s);
+}
+
+
 // Parse objects (plus pass data to certain the player
 // object)
 static void stage_parse_objects(Stage* s) {
@@ -260,19 +748,19 @@ static void stage_parse_objects(Stage* s) {
 
         for(x = 0; x < s->width; ++ x) {
 
-            t = s->data[y*s->width+x];
+            t = STAGE_TILE(s, x, y);
 
             // Boulder
             if(t == 5) {
 
                 stage_add_boulder(s, x, y, 0);
-                s->data[y*s->width+x] = 0;
+                stage_write_tile(s, x, y, 0);
             }
             // Player
             else if(t == 17) {
 
                 s->pl = create_player(x, y);
-                s->data[y*s->width+x] = 0;
+                stage_write_tile(s, x, y, 0);
             }
             // Gem
             else if(t == 22) {
@@ -283,7 +771,7 @@ static void stage_parse_objects(Stage* s) {
             else if(t == 23) {
 
                 stage_add_boulder(s, x, y, 2);
-                s->data[y*s->width+x] = 0;
+                stage_write_tile(s, x, y, 0);
             }
         }
     }
@@ -301,16 +789,19 @@ static void stage_parse_objects(Stage* s) {
 // Set solid
 static void stage_set_solid(Stage* s) {
 
-    uint8 x, y;
+    int16 x, y;
     uint8 t;
-    int16 p;
-    for(y = 0; y < s->height; ++ y) {
 
-        for(x = 0; x < s->width; ++ x) {
+    // Clear the bit-planes
+    memset(s->planes, 0, sizeof(s->planes));
+
+    // Also the sentinel ring
+    for(y = -1; y <= s->height; ++ y) {
+
+        for(x = -1; x <= s->width; ++ x) {
 
             t = 0;
-            p = y*s->width+x;
-            switch (s->data[p])
+            switch (STAGE_TILE(s, x, y))
             {
 
             // Solid wall
@@ -359,7 +850,7 @@ static void stage_set_solid(Stage* s) {
             default:
                 break;
             }
-            s->solid[p] = t;
+            stage_write_solid(s, (uint8)x, (uint8)y, t);
         }
     }
 }
@@ -377,13 +868,18 @@ Stage* create_stage() {
     }
 
     s->initialized = false;
+    s->instant = false;
+    s->settling = false;
+    s->forked = false;
+    s->headless = false;
 
     return s;
 }
 // Destroy
 void destroy_stage(Stage* s) {
 
-    if(s == NULL) return;
+    // Forks are released with their pool
+    if(s == NULL || s->forked) return;
     stage_refactor(s);
     free(s);
 }
@@ -392,11 +888,11 @@ void destroy_stage(Stage* s) {
 // Destroy a stage object
 void stage_refactor(Stage* s) {
 
-    if(s == NULL || !s->initialized) return;
+    if(s == NULL || !s->initialized || s->forked) return;
 
-    if(s->data != NULL) free(s->data);
-    if(s->solid != NULL) free(s->solid);
+    if(s->tiles != NULL) free(s->tiles);
     if(s->boulders != NULL) free(s->boulders);
+    if(s->active != NULL) free(s->active);
 }
 
 
@@ -412,24 +908,41 @@ int stage_init(Stage* s, const char* mapPath) {
 
         return 1;
     }
+
+    // Check the size
+    if(t->width > STAGE_MAX_WIDTH || t->height-1 > STAGE_MAX_HEIGHT) {
+
+        err_throw_param_1("Stage too big: ", mapPath);
+        destroy_tilemap(t);
+        return 1;
+    }
     s->tmap = t;
+    s->ownsTiles = true;
+    s->ownsBoulders = true;
+    s->pool = NULL;
+    s->forkFailed = false;
+    s->infoChanged = false;
+    s->reachValid = false;
+
+    s->width = t->width;
+    s->height = t->height-1;
+    s->stride = s->width+2;
 
     // Copy data & compute the amount of
     // boulders
-    size = t->width*(t->height-1);
-    s->data = (uint8*)malloc(sizeof(uint8)*size);
-    s->solid = (uint8*)malloc(sizeof(uint8)*size);
-    if(s->data == NULL || s->solid == NULL) {
+    size = s->stride*(s->height+2);
+    s->tiles = (Tile*)calloc(size, sizeof(Tile));
+    if(s->tiles == NULL) {
 
         THROW_MALLOC_ERR;
         return 1;
     }
+    stage_load_tiles(s);
+    stage_find_dead_cells(s);
     s->bcount = 1;
     for(i = 0; i < size; ++ i) {
 
-        tileid =  (uint8)max_int16(t->layers[0] [i+t->width], 16) -16;
-        s->data[i] = tileid;
-        s->solid[i] = 0;
+        tileid = s->tiles[i].id;
 
         // If boulder
         if(tileid == 5 || tileid == 3 || tileid == 6 || tileid == 23) {
@@ -437,8 +950,6 @@ int stage_init(Stage* s, const char* mapPath) {
             ++ s->bcount;
         }
     }
-    s->width = t->width;
-    s->height = t->height-1;
 
     // Set defaults
     s->frameDrawn = false;
@@ -452,7 +963,8 @@ int stage_init(Stage* s, const char* mapPath) {
 
     // Allocate memory
     s->boulders = (Boulder*)calloc(s->bcount, sizeof(Boulder));
-    if(s->boulders == NULL) {
+    s->active = (uint8*)malloc(sizeof(uint8)*s->bcount);
+    if(s->boulders == NULL || s->active == NULL) {
 
         THROW_MALLOC_ERR;
         return 1;
@@ -462,6 +974,8 @@ int stage_init(Stage* s, const char* mapPath) {
 
         s->boulders[i].exist = false;
     }
+    s->activeCount = 0;
+    s->activeDirty = true;
 
     // Set solid data
     stage_set_solid(s);
@@ -469,6 +983,9 @@ int stage_init(Stage* s, const char* mapPath) {
     // Parse objects
     stage_parse_objects(s);
 
+    // Compute hash & observation
+    stage_compute_state(s);
+
     s->initialized = true;
 
     return 0;
@@ -488,20 +1005,32 @@ void stage_init_assets(Stage* s) {
 }
 
 
-// Update stage
-void stage_update(Stage* s, int steps) {
-
-    const int LAVA_SPEED = 8;
-    const int LAVA_GLOW_SPEED = 4;
+// Is a turn still being resolved
+static boolean stage_turn_active(Stage* s) {
 
     uint8 i;
+    Boulder* b;
 
-    // Update lava timers
-    s->lavaTimer += LAVA_SPEED * steps;
-    s->lavaTimer %= 16 * FIXED_PREC;
+    if(s->animTimer > 0 || s->pl.moving)
+        return true;
 
-    s->lavaGlowTimer += LAVA_GLOW_SPEED * steps;
-    s->lavaGlowTimer %= 4 * FIXED_PREC;
+    for(i = 0; i < s->activeCount; ++ i) {
+
+        b = &s->boulders[s->active[i]];
+        if(b->exist && 
+           (b->moving || (b->type == 1 && b->bombTimer <= 0)) )
+            return true;
+    }
+
+    return false;
+}
+
+
+// Update objects & animations
+static void stage_update_objects(Stage* s, int steps) {
+
+    uint8 i;
+    uint8 x, y;
 
     // Update animation timer
     if(s->animTimer > 0) {
@@ -512,16 +1041,25 @@ void stage_update(Stage* s, int steps) {
             s->animTimer = 0;
 
             if(s->animMode != 5)
-                s->data[s->animPos.y*s->width+s->animPos.x] = 0;
+                stage_write_tile(s, s->animPos.x, s->animPos.y, 0);
             else {
 
                 // Needed to get rid of certain
-                // "artefacts"
-                stage_draw_static(s, 
-                    s->animPos.x-1, s->animPos.y-1,
-                    s->animPos.x+1, s->animPos.y+1,
-                    s->topLeft.x, s->topLeft.y, 0);
-                s->pl.redraw = true;
+                // "artefacts". Headless stages are not
+                // drawn, and shared tiles must be copied
+                // before the flags are touched
+                if(!s->headless && stage_own_tiles(s)) {
+
+                    for(y = s->animPos.y-1; y <= s->animPos.y+1; ++ y) {
+
+                        for(x = s->animPos.x-1; x <= s->animPos.x+1; ++ x) {
+
+                            STAGE_CELL(s, x, y).flags |= TILE_DIRTY;
+                        }
+                    }
+                    s->dirty = true;
+                    s->pl.redraw = true;
+                }
             }
 
             // Make sure the player is not moving
@@ -540,10 +1078,17 @@ void stage_update(Stage* s, int steps) {
         return;
     }
 
-    // Update boulders
-    for(i = 0; i < s->bcount; ++ i) {
+    // Update active boulders
+    if(s->activeDirty ||
+       s->activeTarget.x != s->pl.target.x || 
+       s->activeTarget.y != s->pl.target.y) {
+
+        stage_collect_active(s);
+    }
+    for(i = 0; i < s->activeCount; ++ i) {
 
-        boulder_update(&s->boulders[i], (void*)&s->pl, (void*)s, steps);
+        boulder_update(&s->boulders[s->active[i]], 
+            (void*)&s->pl, (void*)s, steps);
     }
 
     // Update players
@@ -551,6 +1096,42 @@ void stage_update(Stage* s, int steps) {
 }
 
 
+// Update stage
+void stage_update(Stage* s, int steps) {
+
+    const int LAVA_SPEED = 8;
+    const int LAVA_GLOW_SPEED = 4;
+
+    int16 i;
+
+    // Forks get their own objects on the
+    // first update
+    if(!stage_own_boulders(s)) return;
+
+    // Update lava timers
+    s->lavaTimer += LAVA_SPEED * steps;
+    s->lavaTimer %= 16 * FIXED_PREC;
+
+    s->lavaGlowTimer += LAVA_GLOW_SPEED * steps;
+    s->lavaGlowTimer %= 4 * FIXED_PREC;
+
+    // Update objects
+    stage_update_objects(s, steps);
+
+    // In the instant mode, resolve the rest of the
+    // turn right away (no new input is read)
+    if(s->instant) {
+
+        s->settling = true;
+        for(i = 0; i < INSTANT_MAX_UPDATES && stage_turn_active(s); ++ i) {
+
+            stage_update_objects(s, INSTANT_STEPS);
+        }
+        s->settling = false;
+    }
+}
+
+
 // Draw stage
 void stage_draw(Stage* s) {
 
@@ -561,6 +1142,8 @@ void stage_draw(Stage* s) {
     int16 topx = s->topLeft.x;
     int16 topy = s->topLeft.y;
 
+    if(s->headless) return;
+
     toggle_clipping(false);
 
     // Draw frames
@@ -571,11 +1154,11 @@ void stage_draw(Stage* s) {
 
         // Left
         w = s->width*2 +2;
-        draw_box_frame(s->bmpFrame,
+        panel_draw_frame(s->bmpFrame,
             16, 8, w, s->height*2 +2, 0);
 
         // Right
-        draw_box_frame(s->bmpFrame,
+        panel_draw_frame(s->bmpFrame,
             (w+2)*8+16, 8, 
             RIGHT_FRAME_WIDTH, s->height*2 +2, 0);
 
@@ -591,6 +1174,9 @@ void stage_draw(Stage* s) {
         s->staticDrawn = true;
     }
 
+    // Draw changed tiles
+    stage_draw_dirty(s, topx, topy);
+
     // Draw lava
     stage_draw_lava(s, topx, topy);
 
@@ -628,6 +1214,7 @@ void stage_draw_static(Stage* s,
     int8 jy = 0;
 
     uint8 t;
+    Tile* c;
     Bitmap* bmp;
 
     for(y = starty; y <= ey; ++ y) {
@@ -639,7 +1226,10 @@ void stage_draw_static(Stage* s,
             jx = 0;
             jy = 0;
 
-            t = s->data[y*s->width+x] ;
+            c = &STAGE_CELL(s, x, y);
+            t = c->id;
+            if(skip == 0)
+                c->flags &= ~TILE_DIRTY;
             if(t == 0) {
 
                 fill_rect(dx + x*16, dy + y*16, 16, 16, 0);
@@ -740,56 +1330,99 @@ void stage_draw_static(Stage* s,
 // Update solid data
 void stage_update_solid(Stage* s, uint8 x, uint8 y, 
     uint8 value) {
-    
-    if(x > s->width-1 || y > s->height-1) 
-        return;
 
-    s->solid[y*s->width+x] = value;
+    stage_write_solid(s, x, y, value);
 }
 
 
 // Get solid tile data
 uint8 stage_get_solid_data(Stage* s, uint8 x, uint8 y) {
 
-    if(x > s->width-1 || y > s->height-1) 
-        return 1;
+    return STAGE_SOLID(s, x, y);
+}
+
+
+// Test a solid bit-plane
+boolean stage_test_plane(Stage* s, uint8 plane, uint8 x, uint8 y) {
+
+    return (s->planes[plane][(uint8)(y+1)] >> (uint8)(x+1)) & 1;
+}
+
+
+// Get the four neighbours of a tile in a solid
+// bit-plane (bits in the arrow key order)
+uint8 stage_get_neighbours(Stage* s, uint8 plane, uint8 x, uint8 y) {
+
+    uint16* rows = s->planes[plane] + (uint8)(y+1);
+    uint8 bit = (uint8)(x+1);
 
-    return s->solid[y*s->width+x];
+    return ((rows[0] >> (bit+1)) & 1) << ArrowRight |
+           ((rows[-1] >> bit) & 1) << ArrowUp |
+           ((rows[0] >> (bit-1)) & 1) << ArrowLeft |
+           ((rows[1] >> bit) & 1) << ArrowDown;
 }
 
 
 // Update tile data
 void stage_update_tile(Stage* s, uint8 x, uint8 y, uint8 value) {
 
-    if(x > s->width-1 || y > s->height-1) 
-        return;
-
     // Activate lava death animation
-    if(s->data[y*s->width+x] == 4 && value == 0) {
+    if(STAGE_TILE(s, x, y) == 4 && value == 0) {
 
         stage_set_animation(s, 4, x, y);
         s->animFrame = -1;
         return;
     }
 
-    s->data[y*s->width+x] = value;
+    stage_write_tile(s, x, y, value);
 }
 
 
 // Get tile data
 uint8 stage_get_tile_data(Stage* s, uint8 x, uint8 y) {
 
-    if(x > s->width-1 || y > s->height-1) 
-        return 0;
+    return STAGE_TILE(s, x, y);
+}
+
+
+// Write tile data directly (no animation)
+void stage_write_tile(Stage* s, uint8 x, uint8 y, uint8 value) {
+
+    uint8 index = STAGE_INDEX(s, x, y);
+    uint8 oldPlane, newPlane;
+    Tile* t;
+
+    if(!stage_own_tiles(s)) return;
+    t = &s->tiles[index];
+
+    // Update hash & observation
+    if(t->id != value) {
+
+        s->hash ^= hash_key(HashTile, index, t->id) ^ 
+            hash_key(HashTile, index, value);
 
-    return s->data[y*s->width+x];
+        oldPlane = get_obs_plane(t->id);
+        newPlane = get_obs_plane(value);
+        if(oldPlane != newPlane) {
+
+            stage_toggle_obs(s, oldPlane, x, y);
+            stage_toggle_obs(s, newPlane, x, y);
+        }
+    }
+
+    t->id = value;
+    t->flags = TILE_DIRTY | 
+        (value == 4 ? TILE_LAVA : 0) |
+        (get_switch_group(value) << TILE_GROUP_SHIFT);
+
+    s->dirty = true;
 }
 
 
 // Item collision
 void stage_item_collision(Player* pl, Stage* s) {
 
-    uint8 t = s->data[pl->pos.y*s->width+pl->pos.x];
+    uint8 t = STAGE_TILE(s, pl->pos.x, pl->pos.y);
     boolean remove = false;
 
     switch (t)
@@ -829,11 +1462,11 @@ void stage_item_collision(Player* pl, Stage* s) {
 
     if(remove) {
 
-        s->data[pl->pos.y*s->width+pl->pos.x] = 0;
-        game_redraw_info(&s->pl);
+        stage_write_tile(s, pl->pos.x, pl->pos.y, 0);
+        s->infoChanged = true;
 
          // Play sound
-        audio_play(S_ITEM);
+        stage_play_sound(s, S_ITEM);
     }
 }
 
@@ -842,9 +1475,11 @@ void stage_item_collision(Player* pl, Stage* s) {
 boolean stage_activate_tile(Player* pl, uint8 tx, uint8 ty, Stage* s) {
 
     uint16 i;
-    uint16 j = ty * s->width + tx;
-    uint8 t = s->solid[j];
-    int16 dif;
+    Tile* sw = &STAGE_CELL(s, tx, ty);
+    uint8 t = sw->solid;
+    uint8 group;
+    uint8 x, y;
+    Tile* p;
     
     s->animFrame = -1;
 
@@ -853,43 +1488,43 @@ boolean stage_activate_tile(Player* pl, uint8 tx, uint8 ty, Stage* s) {
     {
     case 4:
 
-        // Toggle blocks
-        for(i = 0; i < s->width*s->height; ++ i) {
+        // Toggle blocks in the same group
+        group = sw->flags & TILE_GROUP_MASK;
+        for(y = 0; y < s->height; ++ y) {
 
-            dif = ((s->data[j]-1)%16)-((s->data[i]-1)%16);
-            if(dif == 3) {
+            for(x = 0; x < s->width; ++ x) {
 
-                s->solid[i] = 1;
-                s->data[i] -= 3;
-            }
-            else if(dif == 6) {
+                p = &STAGE_CELL(s, x, y);
+                if((p->flags & TILE_GROUP_MASK) != group || p->solid == 4)
+                    continue;
+
+                if(p->id >= 11) {
+
+                    stage_write_solid(s, x, y, 1);
+                    stage_write_tile(s, x, y, p->id-3);
+                }
+                else {
 
-                s->solid[i] = 0;
-                s->data[i] += 3;
+                    stage_write_solid(s, x, y, 0);
+                    stage_write_tile(s, x, y, p->id+3);
+                }
             }
         }
 
-        // Make sure boulders are re-drawn
+        // Make sure objects are re-drawn over
+        // the toggled tiles
         for(i = 0; i < s->bcount; ++ i) {
 
             s->boulders[i].redraw = true;
         }
+        s->pl.redraw = true;
 
         // Toggle switch
-        if(s->data[j] < 17) {
-
-            s->data[j] += 16;
-        }
-        else {
-
-            s->data[j] -= 16;
-        }
-
-        stage_draw_static(s, 1, 1, s->width-2, s->height-2, 
-            s->topLeft.x, s->topLeft.y, 0);
+        stage_write_tile(s, tx, ty, 
+            sw->id < 17 ? sw->id+16 : sw->id-16);
 
         // Sound
-        audio_play(S_BEEP2);
+        stage_play_sound(s, S_BEEP2);
     
         break;
         
@@ -901,10 +1536,10 @@ boolean stage_activate_tile(Player* pl, uint8 tx, uint8 ty, Stage* s) {
             stage_set_animation(s, 1, tx, ty);
 
             -- pl->keys;
-            game_redraw_info(pl);
+            s->infoChanged = true;
 
             // Sound
-            audio_play(S_ACTIVATE);
+            stage_play_sound(s, S_ACTIVATE);
 
             return true;
         }
@@ -920,12 +1555,12 @@ boolean stage_activate_tile(Player* pl, uint8 tx, uint8 ty, Stage* s) {
             stage_set_animation(s, t == 5 ? 1 : 2, tx, ty);
 
             -- pl->pickaxe;
-            game_redraw_info(pl);
+            s->infoChanged = true;
 
             s->animFrame = 0;
 
             // Play sound
-            audio_play(S_BREAK);
+            stage_play_sound(s, S_BREAK);
 
             return true;
         }
@@ -940,12 +1575,12 @@ boolean stage_activate_tile(Player* pl, uint8 tx, uint8 ty, Stage* s) {
             stage_set_animation(s, 4, tx, ty);
 
             -- pl->shovel;
-            game_redraw_info(pl);
+            s->infoChanged = true;
 
             s->animFrame = 3;
 
             // Play sound
-            audio_play(S_BREAK);
+            stage_play_sound(s, S_BREAK);
 
             return true;
         }
@@ -964,10 +1599,10 @@ boolean stage_activate_tile(Player* pl, uint8 tx, uint8 ty, Stage* s) {
             pl->forceRelease = true;
             -- pl->bombs;
             
-            game_redraw_info(pl);
+            s->infoChanged = true;
 
             // Sound
-            audio_play(S_ACTIVATE);
+            stage_play_sound(s, S_ACTIVATE);
 
             return true;
         }
@@ -995,24 +1630,23 @@ void stage_set_animation(Stage* s, uint8 mode, uint8 x, uint8 y) {
 void stage_detonate(Stage* s, uint8 dx, uint8 dy) {
 
     uint8 x, y;
+    uint8 sx, sy, ex, ey;
     uint8 t;
-    int16 p;
     int16 i;
 
     stage_update_solid(s, dx, dy, 0);
 
-    for(y = dy-1; y <= dy+1; ++ y) {
+    // Do not destroy the borders
+    sx = (uint8)max_int16(dx-1, 1);
+    sy = (uint8)max_int16(dy-1, 1);
+    ex = (uint8)min_int16(dx+1, s->width-2);
+    ey = (uint8)min_int16(dy+1, s->height-2);
 
-        for(x = dx-1; x <= dx+1; ++ x) {
+    for(y = sy; y <= ey; ++ y) {
 
-            // Do not destroy the borders
-            // or the tile under the bomb
-            if(x == 0 || y == 0 || 
-               x == s->width-1 || y == s->height-1)
-                continue;
+        for(x = sx; x <= ex; ++ x) {
 
-            p = y*s->width+x;
-            t = s->data[p];
+            t = STAGE_TILE(s, x, y);
             switch (t)
             {
             // Wall or solid color block
@@ -1021,15 +1655,15 @@ void stage_detonate(Stage* s, uint8 dx, uint8 dy) {
             case 8:
             case 9:
             case 10:
-                s->data[p] = 4;
-                s->solid[p] = 3;
+                stage_write_tile(s, x, y, 4);
+                stage_write_solid(s, x, y, 3);
                 break;
 
             // Ice
             case 2:
             case 3:
-                s->data[p] = 0;
-                s->solid[p] = 0;
+                stage_write_tile(s, x, y, 0);
+                stage_write_solid(s, x, y, 0);
                 break;
 
             default:
@@ -1055,16 +1689,11 @@ void stage_detonate(Stage* s, uint8 dx, uint8 dy) {
 void stage_reset(Stage* s) {
 
     int16 i;
-    uint8 tileid;
 
-    // Reset tile & solid data
-    for(i = 0; i < s->width*s->height; ++ i) {
+    if(!stage_own_boulders(s)) return;
 
-        tileid =  (uint8)max_int16(s->tmap->layers[0] [i+s->tmap->width], 16) -16;
-        s->data[i] = tileid;
-        s->solid[i] = 0;
-
-    }
+    // Reset tile data
+    stage_load_tiles(s);
 
     // Set defaults
     s->staticDrawn = false;
@@ -1080,12 +1709,147 @@ void stage_reset(Stage* s) {
 
         s->boulders[i].exist = false;
     }
+    s->activeCount = 0;
+    s->activeDirty = true;
 
     // Set solid data
     stage_set_solid(s);
 
     // Parse objects
     stage_parse_objects(s);
+
+    // Compute hash & observation
+    stage_compute_state(s);
+}
+
+
+// Toggle the tracked state of a boulder
+void stage_track_boulder(Stage* s, Boulder* b) {
+
+    if(!b->exist) return;
+
+    s->hash ^= get_boulder_key(s, b);
+
+    stage_toggle_obs(s, 
+        b->type == 1 ? ObsBombs : (b->type == 2 ? ObsBlackHoles : ObsBoulders),
+        b->pos.x, b->pos.y);
+}
+
+
+// Toggle the tracked state of the player
+void stage_track_player(Stage* s, Player* pl) {
+
+    stage_toggle_obs(s, ObsPlayer, pl->pos.x, pl->pos.y);
+
+    s->hash ^= get_player_key(s, pl);
+}
+
+
+// Compute the state hash from scratch
+uint64 stage_compute_hash(Stage* s) {
+
+    uint16 i;
+    uint16 size = s->stride*(s->height+2);
+    uint64 hash = 0;
+
+    for(i = 0; i < size; ++ i) {
+
+        hash ^= hash_key(HashTile, (uint8)i, s->tiles[i].id) ^
+            hash_key(HashSolid, (uint8)i, s->tiles[i].solid);
+    }
+
+    for(i = 0; i < s->bcount; ++ i) {
+
+        if(s->boulders[i].exist)
+            hash ^= get_boulder_key(s, &s->boulders[i]);
+    }
+
+    return hash ^ get_player_key(s, &s->pl);
+}
+
+
+// Get the state hash
+uint64 stage_get_hash(Stage* s) {
+
+    return s->hash;
+}
+
+
+// Get the region the player can reach
+const uint16* stage_get_reachable(Stage* s) {
+
+    // Recompute, if changed (or if the player
+    // has left the region)
+    if(!s->reachValid || 
+       !((s->reach[s->pl.pos.y+1] >> (s->pl.pos.x+1)) & 1)) {
+
+        stage_compute_reach(s);
+    }
+    return s->reach;
+}
+
+
+// Can the player reach a tile
+boolean stage_is_reachable(Stage* s, uint8 x, uint8 y) {
+
+    return (stage_get_reachable(s)[(uint8)(y+1)] >> (uint8)(x+1)) & 1;
+}
+
+
+// Is a cell dead for boulders
+boolean stage_is_dead_cell(Stage* s, uint8 x, uint8 y) {
+
+    return (s->dead[(uint8)(y+1)] >> (uint8)(x+1)) & 1;
+}
+
+
+// Get the observation planes
+const uint8* stage_get_observation(Stage* s) {
+
+    return &s->obs[0][0][0];
+}
+
+
+// Fork a stage
+Stage* stage_fork(Stage* s, StagePool* pool) {
+
+    Stage* f = (Stage*)stage_pool_alloc(pool, sizeof(Stage));
+    uint8* active = (uint8*)stage_pool_alloc(pool, s->bcount);
+    if(f == NULL || active == NULL) {
+
+        err_throw_no_param("Stage pool is full.");
+        return NULL;
+    }
+    memcpy(f, s, sizeof(Stage));
+
+    f->forked = true;
+    f->headless = true;
+    f->forkFailed = false;
+    f->pool = pool;
+    f->active = active;
+    f->activeDirty = true;
+
+    // The data is shared with the parent until
+    // the fork changes it
+    f->ownsTiles = false;
+    f->ownsBoulders = false;
+
+    return f;
+}
+
+
+// Play a sound, if not headless
+void stage_play_sound(Stage* s, uint8 sound) {
+
+    if(!s->headless)
+        audio_play(sound);
+}
+
+
+// Toggle the instant mode
+void stage_set_instant(Stage* s, boolean state) {
+
+    s->instant = state;
 }
 
 
@@ -1094,6 +1858,8 @@ void stage_redraw(Stage* s) {
 
     int16 i;
 
+    if(s->headless) return;
+
     // Set the render flags for the tiles
     s->staticDrawn = false;
     // Set render flags for the objects
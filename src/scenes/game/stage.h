@@ -11,6 +11,77 @@
 
 #include "boulder.h"
 #include "player.h"
+#include "stagepool.h"
+
+// Maximum stage size (a bit-plane row, including
+// the sentinel ring, is stored in one 16-bit word)
+#define STAGE_MAX_WIDTH 14
+#define STAGE_MAX_HEIGHT 14
+
+// Solid bit-planes
+enum {
+
+    PlaneBlocking = 0,
+    PlanePushable = 1,
+    PlaneLava = 2,
+    PlaneActivatable = 3,
+    PlaneWalkable = 4,
+};
+#define PLANE_COUNT 5
+
+// Tile flags
+#define TILE_DIRTY 1
+#define TILE_LAVA 2
+// Switch group (1-3, 0 if none)
+#define TILE_GROUP_SHIFT 2
+#define TILE_GROUP_MASK (3 << TILE_GROUP_SHIFT)
+
+// Tile record
+typedef struct {
+
+    uint8 id;
+    uint8 solid;
+    uint8 flags;
+
+} Tile;
+
+// Index of a tile in the stage grid. The grid has
+// a one-tile sentinel ring of walls, so x or y being
+// -1 (255) or the width/height are valid positions
+#define STAGE_INDEX(s, x, y) \
+    ((uint8)((y)+1) * (s)->stride + (uint8)((x)+1))
+
+// State hash key kinds
+enum {
+
+    HashTile = 0,
+    HashSolid = 1,
+    HashBoulder = 2,
+    HashPlayer = 3,
+    HashItem = 4,
+};
+
+// Observation planes
+enum {
+
+    ObsWalls = 0,
+    ObsIce = 1,
+    ObsLava = 2,
+    ObsBoulders = 3,
+    ObsBombs = 4,
+    ObsItems = 5,
+    ObsPlayer = 6,
+    ObsSwitches = 7,
+    ObsBombPlaces = 8,
+    ObsBlackHoles = 9,
+};
+#define OBS_PLANE_COUNT 10
+#define OBS_NONE 255
+
+// Unchecked tile lookups
+#define STAGE_CELL(s, x, y) ((s)->tiles[STAGE_INDEX(s, x, y)])
+#define STAGE_TILE(s, x, y) (STAGE_CELL(s, x, y).id)
+#define STAGE_SOLID(s, x, y) (STAGE_CELL(s, x, y).solid)
 
 // Stage type
 typedef struct {
@@ -32,23 +103,61 @@ typedef struct {
     // Map
     Tilemap* tmap;
     // Active map data
-    uint8* data;
-    uint8* solid;
+    Tile* tiles;
     uint8 width, height;
+    uint8 stride;
+    // Solid bit-planes, one word per row
+    uint16 planes [PLANE_COUNT] [STAGE_MAX_HEIGHT+2];
+    // State hash (tiles, solid data, objects)
+    uint64 hash;
+    // The region the player can reach without pushing
+    // or activating anything (in the bit-plane layout)
+    uint16 reach [STAGE_MAX_HEIGHT+2];
+    boolean reachValid;
+    // Cells where a boulder can never be pushed into
+    // lava anymore (computed once, when loaded)
+    uint16 dead [STAGE_MAX_HEIGHT+2];
+    // One-hot observation planes
+    uint8 obs [OBS_PLANE_COUNT] [STAGE_MAX_HEIGHT] [STAGE_MAX_WIDTH];
 
     // Lava timers
     uint16 lavaTimer;
     uint16 lavaGlowTimer;
 
+    // Forking (forks share data with their parent
+    // until they change it)
+    boolean forked;
+    boolean ownsTiles;
+    boolean ownsBoulders;
+    boolean forkFailed;
+    StagePool* pool;
+
+    // No audio or drawing
+    boolean headless;
+    // Item counts have changed
+    boolean infoChanged;
+
+    // Instant mode (each turn is resolved
+    // in one update)
+    boolean instant;
+    boolean settling;
+
     // Rendering flags
     boolean frameDrawn;
     boolean staticDrawn;
+    boolean dirty;
 
     // Objects
     Boulder* boulders;
     Player pl;
     uint8 bcount;
 
+    // Active boulders (indices to the boulder array)
+    uint8* active;
+    uint8 activeCount;
+    boolean activeDirty;
+    Byte2 activeTarget;
+
     // Animation timer
     int8 animTimer;
     uint8 animMode;
@@ -87,12 +196,22 @@ void stage_update_solid(Stage* s, uint8 x, uint8 y, uint8 value);
 // Get solid tile data
 uint8 stage_get_solid_data(Stage* s, uint8 x, uint8 y);
 
+// Test a solid bit-plane
+boolean stage_test_plane(Stage* s, uint8 plane, uint8 x, uint8 y);
+
+// Get the four neighbours of a tile in a solid
+// bit-plane (bits in the arrow key order)
+uint8 stage_get_neighbours(Stage* s, uint8 plane, uint8 x, uint8 y);
+
 // Update tile data
 void stage_update_tile(Stage* s, uint8 x, uint8 y, uint8 value);
 
 // Get tile data
 uint8 stage_get_tile_data(Stage* s, uint8 x, uint8 y);
 
+// Write tile data directly (no animation)
+void stage_write_tile(Stage* s, uint8 x, uint8 y, uint8 value);
+
 // Item collision
 void stage_item_collision(Player* pl, Stage* s);
 
@@ -108,6 +227,49 @@ void stage_detonate(Stage* s, uint8 x, uint8 y);
 // Reset
 void stage_reset(Stage* s);
 
+// Toggle the tracked state (hash, observation) 
+// of a boulder (call before and after changing it)
+void stage_track_boulder(Stage* s, Boulder* b);
+
+// Toggle the tracked state of the player
+// (call before and after changing it)
+void stage_track_player(Stage* s, Player* pl);
+
+// Get the state hash
+uint64 stage_get_hash(Stage* s);
+// Compute the state hash from scratch (the hash
+// is kept up to date, so this is for checking)
+uint64 stage_compute_hash(Stage* s);
+
+// Get the region the player can reach without
+// pushing or activating anything, one word per 
+// row in the bit-plane layout (cached)
+const uint16* stage_get_reachable(Stage* s);
+
+// Can the player reach a tile
+boolean stage_is_reachable(Stage* s, uint8 x, uint8 y);
+
+// Is a cell dead for boulders (a boulder there
+// can never be pushed into lava)
+boolean stage_is_dead_cell(Stage* s, uint8 x, uint8 y);
+
+// Get the observation planes
+// (OBS_PLANE_COUNT x STAGE_MAX_HEIGHT x STAGE_MAX_WIDTH)
+const uint8* stage_get_observation(Stage* s);
+
+// Fork a stage. The fork and its data are allocated
+// from the pool and released with it. Forks copy the
+// data of their parent when they first change it, so
+// the parent (the root stage included) must not change
+// while its forks are in use
+Stage* stage_fork(Stage* s, StagePool* pool);
+
+// Play a sound, if not headless
+void stage_play_sound(Stage* s, uint8 sound);
+
+// Toggle the instant mode
+void stage_set_instant(Stage* s, boolean state);
+
 // Redraw
 void stage_redraw(Stage* s);
 
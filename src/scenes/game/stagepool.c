@@ -0,0 +1,98 @@
+// A bump allocator for forked stages
+// (c) 2019 Jani Nykänen
+
+#include "stagepool.h"
+
+#include "../../core/err.h"
+
+#include <stdlib.h>
+
+
+// Create a stage pool
+StagePool* create_stage_pool(uint16 blockSize, uint16 maxBlocks) {
+
+    // Allocate memory
+    StagePool* p = (StagePool*)malloc(sizeof(StagePool));
+    if(p == NULL) {
+
+        THROW_MALLOC_ERR;
+        return NULL;
+    }
+    p->blocks = (uint8**)calloc(maxBlocks, sizeof(uint8*));
+    if(p->blocks == NULL) {
+
+        THROW_MALLOC_ERR;
+        free(p);
+        return NULL;
+    }
+
+    // Whole aligned units only, so rounded sizes
+    // never overflow
+    p->blockSize = blockSize & ~(STAGE_POOL_ALIGN-1);
+    p->maxBlocks = maxBlocks;
+    p->block = 0;
+    p->used = 0;
+
+    return p;
+}
+
+
+// Destroy
+void destroy_stage_pool(StagePool* p) {
+
+    uint16 i;
+
+    if(p == NULL) return;
+
+    for(i = 0; i < p->maxBlocks; ++ i) {
+
+        free(p->blocks[i]);
+    }
+    free(p->blocks);
+    free(p);
+}
+
+
+// Allocate memory from the pool
+void* stage_pool_alloc(StagePool* p, uint16 size) {
+
+    void* ptr;
+
+    if(size > p->blockSize) return NULL;
+
+    // Keep every member aligned
+    size = (size + STAGE_POOL_ALIGN-1) & ~(STAGE_POOL_ALIGN-1);
+
+    // Go to the next block, if this one is full
+    if(size > p->blockSize - p->used) {
+
+        if(p->block+1 >= p->maxBlocks) 
+            return NULL;
+
+        ++ p->block;
+        p->used = 0;
+    }
+
+    if(p->blocks[p->block] == NULL) {
+
+        p->blocks[p->block] = (uint8*)malloc(p->blockSize);
+        if(p->blocks[p->block] == NULL) {
+
+            THROW_MALLOC_ERR;
+            return NULL;
+        }
+    }
+
+    ptr = (void*)(p->blocks[p->block] + p->used);
+    p->used += size;
+
+    return ptr;
+}
+
+
+// Release everything allocated from the pool
+void stage_pool_clear(StagePool* p) {
+
+    p->block = 0;
+    p->used = 0;
+}
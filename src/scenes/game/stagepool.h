@@ -0,0 +1,42 @@
+// A bump allocator for forked stages
+// (c) 2019 Jani Nykänen
+
+#ifndef __STAGE_POOL__
+#define __STAGE_POOL__
+
+#include "../../core/types.h"
+
+// Allocation alignment (the largest member 
+// of the stage data is 8 bytes)
+#define STAGE_POOL_ALIGN 8
+
+// Stage pool type. Memory is taken from a chain
+// of blocks, so the pool is not limited by the
+// size of a single allocation
+typedef struct {
+
+    uint8** blocks;
+    uint16 blockSize;
+    uint16 maxBlocks;
+    uint16 block;
+    uint16 used;
+
+} StagePool;
+
+// Create a stage pool with at most maxBlocks
+// blocks of blockSize bytes. The blocks are 
+// allocated when needed
+StagePool* create_stage_pool(uint16 blockSize, uint16 maxBlocks);
+
+// Destroy
+void destroy_stage_pool(StagePool* p);
+
+// Allocate memory from the pool. Returns NULL
+// if the pool is full
+void* stage_pool_alloc(StagePool* p, uint16 size);
+
+// Release everything allocated from the pool
+// (the blocks are kept for reuse)
+void stage_pool_clear(StagePool* p);
+
+#endif // __STAGE_POOL__
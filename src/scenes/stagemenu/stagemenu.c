@@ -9,6 +9,7 @@
 #include <math.h>
 
 #include "../../core/graphics.h"
+#include "../../core/panel.h"
 #include "../../core/input.h"
 #include "../../core/application.h"
 #include "../../core/assets.h"
@@ -174,9 +175,7 @@ static void smenu_draw_menu() {
     if(redrawMenu) {
 
         // Draw a box around the header
-        fill_rect(bx-2, by-2, BOX_W+4, BOX_H+4, 146);
-        fill_rect(bx-1, by-1, BOX_W+2, BOX_H+2, 255);
-        fill_rect(bx, by, BOX_W, BOX_H, 0);
+        panel_draw_box(bx, by, BOX_W, BOX_H);
 
         // Draw header
         draw_text_fast(bmpFont, "CHOOSE A STAGE", 
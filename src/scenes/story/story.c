@@ -40,6 +40,9 @@ static int16 chrTimer;
 static int16 chrPos;
 // Text length
 static uint16 len;
+// Characters drawn & the position of the next one
+static int16 drawPos;
+static Vector2 cursor;
 
 // Story textes
 static const char* STORY[] = { 
@@ -123,6 +126,10 @@ static void story_draw() {
     const int16 STORY_Y = 96;
     const int16 STORY_X = 8;
 
+    const char* text = STORY[storyPointer];
+    int16 cw = bmpFont->width / 16;
+    uint8 c;
+
     // Draw background
     if(!bgDrawn) {
 
@@ -134,14 +141,28 @@ static void story_draw() {
 
         bgDrawn = true;
 
-        
+        // Text needs to be redrawn
+        drawPos = 0;
+        cursor = vec2(STORY_X, STORY_Y);
     }
 
     if(!tr_is_active()) {
         
-        // Draw text (temp)
-        draw_substr_fast(bmpFont, STORY[storyPointer], STORY_X, STORY_Y, 0 , 1,
-            chrPos, chrPos+1, false);
+        // Draw the characters revealed since
+        // the last draw
+        for(; drawPos < chrPos && drawPos < (int16)len; ++ drawPos) {
+
+            c = text[drawPos];
+            if(c == '\n') {
+
+                cursor.x = STORY_X;
+                cursor.y += cw + 1;
+                continue;
+            }
+
+            draw_char_fast(bmpFont, c, cursor.x, cursor.y);
+            cursor.x += cw;
+        }
     }
 }
 
@@ -173,6 +194,7 @@ static void story_on_change(void* param) {
     chrPos = 0;
 
     storyPointer = (uint8)param;
+    len = strlen(STORY[storyPointer]);
 }
 
 
@@ -9,6 +9,7 @@
 #include <math.h>
 
 #include "../../core/graphics.h"
+#include "../../core/panel.h"
 #include "../../core/input.h"
 #include "../../core/application.h"
 #include "../../core/assets.h"
@@ -37,6 +38,8 @@ static boolean storyPlayed;
 static int16 logoTimer;
 // Press enter timer
 static int8 enterTimer;
+// Is "press enter" visible (-1 if not drawn yet)
+static int8 enterVisible;
 // Phase
 static uint8 phase;
 
@@ -50,6 +53,7 @@ static Menu menu;
 
 // Confirm screen variables
 static boolean confirmActive;
+static boolean confirmSaved;
 static boolean confirmCursor;
 static uint8 confirmChanged;
 
@@ -171,10 +175,11 @@ static void title_draw_confirm_screen() {
 
     if(confirmChanged) {
 
+        // Save the area under the box
+        confirmSaved = push_save_under(x-2, y-2, WIDTH+4, HEIGHT+4);
+
         // Box
-        fill_rect(x-2, y-2, WIDTH+4, HEIGHT+4, 146);
-        fill_rect(x-1, y-1, WIDTH+2, HEIGHT+2, 255);
-        fill_rect(x, y, WIDTH, HEIGHT, 0);
+        panel_draw_box(x, y, WIDTH, HEIGHT);
 
         // Header
         draw_text_fast(bmpFont, "ARE YOU SURE?", 
@@ -214,6 +219,7 @@ static int16 title_init() {
     logoTimer = INITIAL_LOGO_TIME;
     confirmActive = false;
     confirmChanged = false;
+    confirmSaved = false;
     confirmCursor = 1;
 
     // Check if a save file exists
@@ -258,9 +264,19 @@ static void title_update(int16 steps) {
             
             confirmActive = false;
 
-            bgDrawn = false;
-            menu.redraw = true;
-            logoDrawn = false;
+            // Restore the area under the box, or
+            // redraw everything
+            if(confirmSaved) {
+
+                pop_save_under();
+                confirmSaved = false;
+            }
+            else {
+
+                bgDrawn = false;
+                menu.redraw = true;
+                logoDrawn = false;
+            }
         }
 
         return;
@@ -335,6 +351,7 @@ static void title_draw() {
 
         title_draw_background();
         bgDrawn = true;
+        enterVisible = -1;
     }
 
     if(!logoDrawn || logoTimer > 0) {
@@ -353,15 +370,17 @@ static void title_draw() {
 
     if(phase == 0) {
 
-        // Draw "PRESS ENTER"
-        if(enterTimer < 30) {
+        // Draw "PRESS ENTER", if blinked
+        if(enterTimer < 30 && enterVisible != 1) {
 
             draw_text_fast(bmpFont, "PRESS ENTER", 
                         160, ENTER_Y, 0, 0, true);
+            enterVisible = 1;
         }
-        else {
+        else if(enterTimer >= 30 && enterVisible != 0) {
 
             fill_rect(160 - 8*6,ENTER_Y-8, 16*6, 16, 0);
+            enterVisible = 0;
         }
 
     }
@@ -408,7 +427,11 @@ static void title_on_change(void* param) {
     logoDrawn = false;
     bgDrawn = false;
 
+    // The saved areas were cleared with the scene
+    // change, so the menu has nothing to restore
     menu.redraw = true;
+    menu.saved = false;
+    menu.saveFailed = false;
 
     // Set audio button text
     audio_toggle();
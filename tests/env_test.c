@@ -0,0 +1,137 @@
+// Environment tests
+// (c) 2019 Jani Nykänen
+
+#include "testmap.h"
+
+#include "../src/scenes/game/env.h"
+
+#include <stdlib.h>
+
+// Map path
+static const char* MAP_PATH = "env_test.bin";
+
+// Failed checks
+static int failures;
+
+// Step buffers
+static uint8 actions [1];
+static uint8 obs [ENV_OBS_SIZE];
+static int8 rewards [1];
+static boolean done [1];
+
+
+// Get an observation cell
+static uint8 get_obs(uint8 plane, uint8 x, uint8 y) {
+
+    return obs[plane*ENV_OBS_PLANE_SIZE + y*ENV_OBS_WIDTH + x];
+}
+
+
+// Step the only environment
+static void step(EnvBatch* e, uint8 action) {
+
+    actions[0] = action;
+    env_step(e, actions, obs, rewards, done);
+}
+
+
+// Pushing a boulder moves it
+static void test_push_boulder() {
+
+    const char* ROWS[] = {
+        ".......",
+        ".PB....",
+        ".......",
+    };
+    EnvBatch* e;
+    Stage* s;
+
+    write_test_map(MAP_PATH, 0, 0, 0, 7, 3, ROWS);
+    e = create_env_batch(MAP_PATH, 1, 0);
+    CHECK(e != NULL);
+    if(e == NULL) return;
+    s = e->stages[0];
+
+    step(e, ActionRight);
+
+    CHECK(s->pl.pos.x == 2 && s->pl.pos.y == 1);
+    CHECK(!s->pl.moving);
+    CHECK(get_obs(ObsPlayer, 2, 1) == 1);
+    CHECK(get_obs(ObsBoulders, 2, 1) == 0);
+    CHECK(get_obs(ObsBoulders, 3, 1) == 1);
+    CHECK(STAGE_SOLID(s, 3, 1) != 0);
+    CHECK(STAGE_SOLID(s, 2, 1) == 0);
+
+    // Nothing can be pushed to the outermost tiles
+    step(e, ActionRight);
+    step(e, ActionRight);
+    CHECK(s->pl.pos.x == 4);
+    CHECK(get_obs(ObsBoulders, 5, 1) == 1);
+    step(e, ActionRight);
+    CHECK(s->pl.pos.x == 4);
+    CHECK(get_obs(ObsBoulders, 5, 1) == 1);
+    CHECK(get_obs(ObsBoulders, 6, 1) == 0);
+
+    destroy_env_batch(e);
+}
+
+
+// Placing a bomb & walking ticks the timer
+static void test_bomb_timer() {
+
+    const char* ROWS[] = {
+        "......",
+        "....H.",
+        ".PX...",
+        "......",
+        "......",
+    };
+    EnvBatch* e;
+    Stage* s;
+
+    write_test_map(MAP_PATH, 0, 0, 1, 6, 5, ROWS);
+    e = create_env_batch(MAP_PATH, 1, 0);
+    CHECK(e != NULL);
+    if(e == NULL) return;
+    s = e->stages[0];
+
+    // Bomb places are floor, black holes
+    // are not boulders
+    step(e, ActionNone);
+    CHECK(get_obs(ObsBombPlaces, 2, 2) == 1);
+    CHECK(get_obs(ObsWalls, 2, 2) == 0);
+    CHECK(get_obs(ObsBlackHoles, 4, 1) == 1);
+    CHECK(get_obs(ObsBoulders, 4, 1) == 0);
+
+    // Place the bomb
+    step(e, ActionRight);
+    CHECK(s->pl.pos.x == 1);
+    CHECK(s->pl.bombs == 0);
+    CHECK(get_obs(ObsBombs, 2, 2) == 1);
+    CHECK(get_obs(ENV_OBS_BOMB_TIMERS, 2, 2) == 5);
+
+    // Each move is a turn
+    step(e, ActionDown);
+    CHECK(s->pl.pos.y == 3);
+    CHECK(get_obs(ENV_OBS_BOMB_TIMERS, 2, 2) == 4);
+    step(e, ActionUp);
+    CHECK(get_obs(ENV_OBS_BOMB_TIMERS, 2, 2) == 3);
+
+    destroy_env_batch(e);
+}
+
+
+int main() {
+
+    test_push_boulder();
+    test_bomb_timer();
+
+    remove(MAP_PATH);
+
+    if(failures > 0) {
+
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,160 @@
+// Stage fork tests
+// (c) 2019 Jani Nykänen
+
+#include "testmap.h"
+
+#include "../src/scenes/game/stage.h"
+#include "../src/core/input.h"
+
+#include <stdlib.h>
+
+// Map path
+static const char* MAP_PATH = "fork_test.bin";
+
+// Failed checks
+static int failures;
+
+// Test map
+static const char* ROWS[] = {
+    ".......",
+    ".PB.G..",
+    ".......",
+    "......G",
+};
+
+
+// Load the test map to a headless stage
+static Stage* load_stage() {
+
+    Stage* s = create_stage();
+    if(s == NULL) return NULL;
+
+    write_test_map(MAP_PATH, 0, 0, 0, 7, 4, ROWS);
+    if(stage_init(s, MAP_PATH) != 0) {
+
+        destroy_stage(s);
+        return NULL;
+    }
+    s->headless = true;
+    s->instant = true;
+
+    return s;
+}
+
+
+// Move the player of a stage
+static void move_player(Stage* s, uint8 arrow) {
+
+    pl_queue_move(&s->pl, arrow);
+    stage_update(s, 1);
+}
+
+
+// Changes to a fork are not seen by the parent
+// or the other forks
+static void test_isolation() {
+
+    Stage* s = load_stage();
+    StagePool* pool = create_stage_pool(4096, 64);
+    Stage* a;
+    Stage* b;
+    uint64 hash;
+
+    CHECK(s != NULL && pool != NULL);
+    if(s == NULL || pool == NULL) return;
+
+    hash = stage_get_hash(s);
+    a = stage_fork(s, pool);
+    b = stage_fork(s, pool);
+    CHECK(a != NULL && b != NULL);
+    if(a == NULL || b == NULL) return;
+
+    // Push the boulder & pick up the gem
+    move_player(a, ArrowRight);
+    move_player(a, ArrowRight);
+    move_player(a, ArrowRight);
+    CHECK(!a->forkFailed);
+    CHECK(a->pl.pos.x == 4);
+    CHECK(a->pl.gems == 1);
+    CHECK(STAGE_TILE(a, 4, 1) == 0);
+    CHECK(STAGE_SOLID(a, 5, 1) != 0);
+    CHECK(stage_get_hash(a) != hash);
+
+    CHECK(stage_get_hash(s) == hash);
+    CHECK(stage_get_hash(b) == hash);
+    CHECK(s->pl.pos.x == 1 && b->pl.pos.x == 1);
+    CHECK(STAGE_TILE(s, 4, 1) == 22 && STAGE_TILE(b, 4, 1) == 22);
+    CHECK(STAGE_SOLID(s, 2, 1) != 0 && STAGE_SOLID(b, 2, 1) != 0);
+    CHECK(STAGE_SOLID(s, 5, 1) == 0 && STAGE_SOLID(b, 5, 1) == 0);
+
+    // The sibling still works from the parent data
+    move_player(b, ArrowDown);
+    CHECK(!b->forkFailed);
+    CHECK(b->pl.pos.y == 2);
+    CHECK(stage_get_hash(b) == stage_compute_hash(b));
+    CHECK(STAGE_SOLID(b, 2, 1) != 0);
+
+    // Forks of forks
+    b = stage_fork(a, pool);
+    CHECK(b != NULL);
+    if(b != NULL) {
+
+        move_player(b, ArrowLeft);
+        CHECK(b->pl.pos.x == 3 && a->pl.pos.x == 4);
+        CHECK(STAGE_SOLID(a, 5, 1) != 0);
+    }
+
+    destroy_stage_pool(pool);
+    destroy_stage(s);
+}
+
+
+// Running out of pool memory fails the fork
+static void test_exhaustion() {
+
+    Stage* s = load_stage();
+    StagePool* pool;
+    Stage* f;
+
+    CHECK(s != NULL);
+    if(s == NULL) return;
+
+    // Room for the fork itself, but not for its
+    // private copies
+    pool = create_stage_pool(
+        (uint16)(sizeof(Stage) + 2*STAGE_POOL_ALIGN), 1);
+    CHECK(pool != NULL);
+    if(pool == NULL) return;
+
+    f = stage_fork(s, pool);
+    CHECK(f != NULL);
+    CHECK(((size_t)f & (STAGE_POOL_ALIGN-1)) == 0);
+    if(f == NULL) return;
+
+    move_player(f, ArrowRight);
+    CHECK(f->forkFailed);
+    CHECK(stage_fork(s, pool) == NULL);
+
+    // Clearing makes room again
+    stage_pool_clear(pool);
+    CHECK(stage_fork(s, pool) != NULL);
+
+    destroy_stage_pool(pool);
+    destroy_stage(s);
+}
+
+
+int main() {
+
+    test_isolation();
+    test_exhaustion();
+
+    remove(MAP_PATH);
+
+    if(failures > 0) {
+
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,84 @@
+// Graphics kernel tests
+// (c) 2019 Jani Nykänen
+
+#include "testmap.h"
+
+// The kernels are static
+#include "../src/core/graphics.c"
+
+// Failed checks
+static int failures;
+
+// Row buffers (with room for misaligned rows)
+static uint8 source [64];
+static uint8 expected [64];
+static uint8 result [64];
+
+
+// Draw a row pixel by pixel
+static void blit_row_reference(uint8* dst, const uint8* src, 
+    int16 w, bool flip) {
+
+    int16 x;
+    uint8 p;
+
+    for(x = 0; x < w; ++ x) {
+
+        p = flip ? src[-x] : src[x];
+        if(p != ALPHA)
+            dst[x] = p;
+    }
+}
+
+
+// The word kernel matches the pixel loop for
+// every width, alignment & direction
+static void test_blit_masked_row() {
+
+    int16 w, off, i;
+    int flip;
+    const uint8* src;
+
+    srand(1);
+    for(i = 0; i < (int16)sizeof(source); ++ i) {
+
+        source[i] = (rand() % 3 == 0) ? ALPHA : (uint8)rand();
+    }
+
+    for(flip = 0; flip < 2; ++ flip) {
+
+        for(w = 1; w <= 33; ++ w) {
+
+            for(off = 0; off < 4; ++ off) {
+
+                for(i = 0; i < (int16)sizeof(result); ++ i) {
+
+                    expected[i] = result[i] = (uint8)(i * 7);
+                }
+
+                src = flip ? source + off + w - 1 : source + off;
+                blit_row_reference(expected + off, src, w, flip);
+                blit_masked_row(result + off, src, w, flip);
+
+                if(memcmp(expected, result, sizeof(result)) != 0) {
+
+                    printf("width %d, offset %d, flip %d\n", w, off, flip);
+                    CHECK(false);
+                }
+            }
+        }
+    }
+}
+
+
+int main() {
+
+    test_blit_masked_row();
+
+    if(failures > 0) {
+
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    return 0;
+}
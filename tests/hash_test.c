@@ -0,0 +1,132 @@
+// State hash tests
+// (c) 2019 Jani Nykänen
+
+#include "testmap.h"
+
+#include "../src/scenes/game/env.h"
+
+#include <stdlib.h>
+
+// Map path
+static const char* MAP_PATH = "hash_test.bin";
+
+// Failed checks
+static int failures;
+
+// Step buffers
+static uint8 actions [1];
+static uint8 obs [ENV_OBS_SIZE];
+static int8 rewards [1];
+static boolean done [1];
+
+
+// Step the only environment & compare the kept 
+// hash to a from-scratch one
+static void step(EnvBatch* e, uint8 action) {
+
+    Stage* s = e->stages[0];
+
+    actions[0] = action;
+    env_step(e, actions, obs, rewards, done);
+
+    CHECK(stage_get_hash(s) == stage_compute_hash(s));
+}
+
+
+// Pushes, pickups & switch toggles
+static void test_push_pickup_switch() {
+
+    const char* ROWS[] = {
+        ".........",
+        ".PB......",
+        "..G.OC...",
+        "..S......",
+        "........G",
+    };
+    EnvBatch* e;
+    Stage* s;
+    uint64 start;
+
+    write_test_map(MAP_PATH, 0, 0, 0, 9, 5, ROWS);
+    e = create_env_batch(MAP_PATH, 1, 0);
+    CHECK(e != NULL);
+    if(e == NULL) return;
+    s = e->stages[0];
+
+    start = stage_get_hash(s);
+    CHECK(start == stage_compute_hash(s));
+
+    // Push
+    step(e, ActionRight);
+    CHECK(s->pl.pos.x == 2);
+    CHECK(stage_get_hash(s) != start);
+
+    // Pick up a gem (not the last one, that would
+    // reset the stage)
+    step(e, ActionDown);
+    CHECK(s->pl.pos.y == 2);
+    CHECK(s->pl.gems == 1);
+
+    // Toggle the switch
+    step(e, ActionDown);
+    CHECK(s->pl.pos.y == 2);
+    CHECK(STAGE_SOLID(s, 4, 2) != 0);
+    CHECK(STAGE_SOLID(s, 5, 2) == 0);
+
+    // And back
+    step(e, ActionDown);
+    CHECK(STAGE_SOLID(s, 4, 2) == 0);
+    CHECK(STAGE_SOLID(s, 5, 2) != 0);
+
+    destroy_env_batch(e);
+}
+
+
+// Bomb detonations
+static void test_bomb() {
+
+    const char* ROWS[] = {
+        "#########",
+        "......#..",
+        ".PX...#..",
+        "......#..",
+        ".........",
+    };
+    EnvBatch* e;
+    Stage* s;
+    uint8 i;
+
+    write_test_map(MAP_PATH, 0, 0, 1, 9, 5, ROWS);
+    e = create_env_batch(MAP_PATH, 1, 0);
+    CHECK(e != NULL);
+    if(e == NULL) return;
+    s = e->stages[0];
+
+    // Place the bomb, push it & walk until
+    // it goes off
+    for(i = 0; i < 4; ++ i) {
+
+        step(e, ActionRight);
+    }
+    step(e, ActionLeft);
+    step(e, ActionLeft);
+    CHECK(STAGE_TILE(s, 6, 2) == 4);
+
+    destroy_env_batch(e);
+}
+
+
+int main() {
+
+    test_push_pickup_switch();
+    test_bomb();
+
+    remove(MAP_PATH);
+
+    if(failures > 0) {
+
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    return 0;
+}
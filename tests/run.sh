@@ -0,0 +1,35 @@
+#!/bin/sh
+# Build & run the host tests. The DOS headers are 
+# replaced with the stand-ins in stubs/
+cd "$(dirname "$0")"
+
+SRC="../src/core/err.c ../src/core/types.c ../src/core/mathext.c \
+../src/core/tilemap.c ../src/core/bitmap.c ../src/core/graphics.c \
+../src/core/panel.c ../src/core/assets.c ../src/core/audio.c \
+../src/core/sprite.c ../src/core/input.c ../src/core/timer.c ../src/scenes/game/stage.c \
+../src/scenes/game/stagepool.c ../src/scenes/game/boulder.c \
+../src/scenes/game/player.c ../src/scenes/game/env.c \
+stubs/stubs.c testmap.c"
+
+mkdir -p bin
+status=0
+for test in *_test.c; do
+
+    name=$(basename "$test" .c)
+
+    # Sources a test includes directly (for the static
+    # functions) are not linked again
+    src=""
+    for file in $SRC; do
+        grep -q "^#include \"$file\"" "$test" || src="$src $file"
+    done
+
+    gcc -std=gnu99 -Wall -Werror -Istubs "$test" $src -o "bin/$name" -lm || exit 1
+    if ./"bin/$name"; then
+        echo "PASS $name"
+    else
+        echo "FAIL $name"
+        status=1
+    fi
+done
+exit $status
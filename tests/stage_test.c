@@ -0,0 +1,208 @@
+// Stage tests
+// (c) 2019 Jani Nykänen
+
+#include "testmap.h"
+
+#include "../src/scenes/game/env.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Map path
+static const char* MAP_PATH = "stage_test.bin";
+
+// Failed checks
+static int failures;
+
+// Step buffers
+static uint8 actions [1];
+static uint8 obs [ENV_OBS_SIZE];
+static int8 rewards [1];
+static boolean done [1];
+
+
+// Step the only environment
+static void step(EnvBatch* e, uint8 action) {
+
+    actions[0] = action;
+    env_step(e, actions, obs, rewards, done);
+}
+
+
+// A bomb pushed away from its bomb place blasts
+// walls outside the bomb place neighbourhood, so
+// the cells behind them are not dead
+static void test_pushed_bomb() {
+
+    const char* ROWS[] = {
+        "#########",
+        "......#..",
+        ".PX...#..",
+        "......#..",
+        ".........",
+    };
+    EnvBatch* e;
+    Stage* s;
+    uint8 i;
+
+    write_test_map(MAP_PATH, 0, 0, 1, 9, 5, ROWS);
+    e = create_env_batch(MAP_PATH, 1, 0);
+    CHECK(e != NULL);
+    if(e == NULL) return;
+    s = e->stages[0];
+
+    // The wall may become lava
+    CHECK(!stage_is_dead_cell(s, 5, 1));
+    CHECK(!stage_is_dead_cell(s, 5, 3));
+    // The top row is never destroyed
+    CHECK(stage_is_dead_cell(s, 1, 1));
+
+    // Place the bomb & push it three times
+    for(i = 0; i < 4; ++ i) {
+
+        step(e, ActionRight);
+    }
+    CHECK(s->pl.pos.x == 4);
+    CHECK(STAGE_TILE(s, 6, 2) == 1);
+
+    // Walk until it goes off
+    step(e, ActionLeft);
+    step(e, ActionLeft);
+    CHECK(s->pl.pos.x == 2);
+    CHECK(STAGE_TILE(s, 6, 1) == 4);
+    CHECK(STAGE_TILE(s, 6, 2) == 4);
+    CHECK(STAGE_TILE(s, 6, 3) == 4);
+    CHECK(STAGE_TILE(s, 6, 0) == 1);
+
+    destroy_env_batch(e);
+}
+
+
+// Open color blocks in a blast area can be switched
+// solid & blasted to lava
+static void test_open_blocks() {
+
+    const char* ROWS[] = {
+        "######",
+        ".X.O..",
+        "......",
+        "######",
+    };
+    Stage* s = create_stage();
+
+    CHECK(s != NULL);
+    if(s == NULL) return;
+
+    write_test_map(MAP_PATH, 0, 0, 1, 6, 4, ROWS);
+    CHECK(stage_init(s, MAP_PATH) == 0);
+    s->headless = true;
+
+    CHECK(!stage_is_dead_cell(s, 2, 1));
+    // Nothing to blast next to the bottom wall
+    CHECK(stage_is_dead_cell(s, 2, 2));
+
+    destroy_stage(s);
+}
+
+
+// Flood fill the empty tiles from the player, and
+// compare with the kept reachable region
+static boolean check_reach(Stage* s) {
+
+    uint16 reach [STAGE_MAX_HEIGHT+2];
+    boolean changed = true;
+    boolean near;
+    uint8 x, y;
+
+    memset(reach, 0, sizeof(reach));
+    reach[s->pl.pos.y+1] = 1 << (s->pl.pos.x+1);
+    while(changed) {
+
+        changed = false;
+        for(y = 1; y < s->height-1; ++ y) {
+
+            for(x = 1; x < s->width-1; ++ x) {
+
+                near = ((reach[y] >> x) | (reach[y+2] >> x) |
+                    (reach[y+1] >> (x+2)) | (reach[y+1] >> x)) & 1;
+                if(near && STAGE_SOLID(s, x, y) == 0 &&
+                   !((reach[y+1] >> (x+1)) & 1)) {
+
+                    reach[y+1] |= 1 << (x+1);
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    for(y = 0; y < s->height; ++ y) {
+
+        for(x = 0; x < s->width; ++ x) {
+
+            if(stage_is_reachable(s, x, y) != ((reach[y+1] >> (x+1)) & 1))
+                return false;
+        }
+    }
+    return true;
+}
+
+
+// Opening & closing a color block on the boundary
+// of the reachable region invalidates it
+static void test_reach() {
+
+    const char* ROWS[] = {
+        "........",
+        ".P.#....",
+        "...C....",
+        ".S.#....",
+        "........",
+    };
+    EnvBatch* e;
+    Stage* s;
+
+    write_test_map(MAP_PATH, 0, 0, 0, 8, 5, ROWS);
+    e = create_env_batch(MAP_PATH, 1, 0);
+    CHECK(e != NULL);
+    if(e == NULL) return;
+    s = e->stages[0];
+
+    CHECK(check_reach(s));
+    CHECK(!stage_is_reachable(s, 5, 2));
+    step(e, ActionDown);
+    CHECK(s->reachValid);
+
+    // Open
+    step(e, ActionDown);
+    CHECK(s->pl.pos.y == 2);
+    CHECK(STAGE_SOLID(s, 3, 2) == 0);
+    CHECK(!s->reachValid);
+    CHECK(check_reach(s));
+    CHECK(stage_is_reachable(s, 5, 2));
+
+    // Close
+    step(e, ActionDown);
+    CHECK(STAGE_SOLID(s, 3, 2) != 0);
+    CHECK(!s->reachValid);
+    CHECK(check_reach(s));
+    CHECK(!stage_is_reachable(s, 5, 2));
+
+    destroy_env_batch(e);
+}
+
+
+int main() {
+
+    test_pushed_bomb();
+    test_open_blocks();
+    test_reach();
+
+    remove(MAP_PATH);
+
+    if(failures > 0) {
+
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,7 @@
+// Host stand-in for <bios.h>
+#ifndef __STUB_BIOS_H__
+#define __STUB_BIOS_H__
+
+unsigned _bios_keybrd(unsigned cmd);
+
+#endif // __STUB_BIOS_H__
@@ -0,0 +1,8 @@
+// Host stand-in for <conio.h>
+#ifndef __STUB_CONIO_H__
+#define __STUB_CONIO_H__
+
+unsigned inp(unsigned port);
+unsigned outp(unsigned port, unsigned value);
+
+#endif // __STUB_CONIO_H__
@@ -0,0 +1,10 @@
+// Host stand-in for <dos.h>
+#ifndef __STUB_DOS_H__
+#define __STUB_DOS_H__
+
+#include "i86.h"
+
+void (*_dos_getvect(int id))();
+void _dos_setvect(int id, void (*handler)());
+
+#endif // __STUB_DOS_H__
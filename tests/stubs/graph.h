@@ -0,0 +1,10 @@
+// Host stand-in for <graph.h>
+#ifndef __STUB_GRAPH_H__
+#define __STUB_GRAPH_H__
+
+#define _MRES256COLOR 0x13
+#define _DEFAULTMODE -1
+
+short _setvideomode(short mode);
+
+#endif // __STUB_GRAPH_H__
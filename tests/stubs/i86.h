@@ -0,0 +1,19 @@
+// Host stand-in for <i86.h>
+#ifndef __STUB_I86_H__
+#define __STUB_I86_H__
+
+#define far
+#define interrupt
+
+struct WORDREGS { unsigned short ax, bx, cx, dx, si, di, cflag; };
+struct BYTEREGS { unsigned char al, ah, bl, bh, cl, ch, dl, dh; };
+union REGS { struct WORDREGS w; struct WORDREGS x; struct BYTEREGS h; };
+
+int int86(int id, union REGS* in, union REGS* out);
+void _disable();
+void _enable();
+void sound(unsigned freq);
+void nosound();
+void delay(unsigned ms);
+
+#endif // __STUB_I86_H__
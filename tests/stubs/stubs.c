@@ -0,0 +1,23 @@
+// Host stand-ins for the DOS functions, so that
+// the game logic can be tested without DOS
+// (c) 2019 Jani Nykänen
+
+#include "dos.h"
+#include "conio.h"
+#include "graph.h"
+#include "bios.h"
+
+#include <stdlib.h>
+
+void (*_dos_getvect(int id))() { return NULL; }
+void _dos_setvect(int id, void (*handler)()) {}
+int int86(int id, union REGS* in, union REGS* out) { return 0; }
+void _disable() {}
+void _enable() {}
+void sound(unsigned freq) {}
+void nosound() {}
+void delay(unsigned ms) {}
+unsigned inp(unsigned port) { return 0; }
+unsigned outp(unsigned port, unsigned value) { return value; }
+short _setvideomode(short mode) { return 0; }
+unsigned _bios_keybrd(unsigned cmd) { return 0; }
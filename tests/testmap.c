@@ -0,0 +1,70 @@
+// Test maps
+// (c) 2019 Jani Nykänen
+
+#include "testmap.h"
+
+#include "../src/core/types.h"
+
+
+// Get the tile id of a map character
+static uint8 get_tile_id(char c) {
+
+    switch (c)
+    {
+    case '#': return 1;
+    case 'L': return 4;
+    case 'B': return 5;
+    case 'X': return 6;
+    case 'C': return 8;
+    case 'O': return 11;
+    case 'S': return 14;
+    case 'P': return 17;
+    case 'G': return 22;
+    case 'H': return 23;
+
+    default:
+        return 0;
+    }
+}
+
+
+// Write a map file
+int write_test_map(const char* path, 
+    int pickaxe, int shovel, int bombs, 
+    int width, int height, const char** rows) {
+
+    uint16 w = (uint16)width;
+    uint16 h = (uint16)(height+1);
+    uint8 layers = 1;
+    uint8 v;
+    int x, y;
+
+    FILE* f = fopen(path, "wb");
+    if(f == NULL) 
+        return 1;
+
+    fwrite(&w, sizeof(uint16), 1, f);
+    fwrite(&h, sizeof(uint16), 1, f);
+    fwrite(&layers, sizeof(uint8), 1, f);
+
+    // The first row holds the item counts
+    for(x = 0; x < width; ++ x) {
+
+        v = x == 0 ? pickaxe+1 : x == 1 ? shovel+1 : x == 2 ? bombs+1 : 0;
+        fwrite(&v, sizeof(uint8), 1, f);
+    }
+
+    // Tiles are stored from 16 onwards
+    for(y = 0; y < height; ++ y) {
+
+        for(x = 0; x < width; ++ x) {
+
+            v = get_tile_id(rows[y][x]);
+            v = v == 0 ? 0 : v + 16;
+            fwrite(&v, sizeof(uint8), 1, f);
+        }
+    }
+
+    fclose(f);
+    return 0;
+}
@@ -0,0 +1,24 @@
+// Test maps
+// (c) 2019 Jani Nykänen
+
+#ifndef __TESTMAP__
+#define __TESTMAP__
+
+#include <stdio.h>
+
+// Check a condition, count the failures
+#define CHECK(cond) do { if(!(cond)) { \
+    printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+    ++ failures; } } while(0)
+
+// Write a map file from rows of characters:
+// '.' empty, '#' wall, 'P' player, 'B' boulder, 
+// 'X' bomb place, 'L' lava, 'G' gem, 'O' open
+// color block, 'C' solid color block, 'S' switch
+// of their color, 'H' black hole. The item counts
+// are pickaxes, shovels & bombs
+int write_test_map(const char* path, 
+    int pickaxe, int shovel, int bombs, 
+    int width, int height, const char** rows);
+
+#endif // __TESTMAP__